@@ -0,0 +1,105 @@
+#include "log_writer.hpp"
+
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+
+LogWriter::LogWriter(): slots(std::make_unique<Slot[]>(capacity))
+{
+    for (size_t i = 0; i < capacity; i++)
+    {
+        slots[i].sequence.store(i, std::memory_order_relaxed);
+    }
+    std::thread(&LogWriter::work, this).detach();
+}
+
+LogWriter& LogWriter::instance()
+{
+    // Never destroyed, lines logged by static destructors still find a writer.
+    static LogWriter* const writer = []
+    {
+        auto writer = new LogWriter();
+        std::atexit([] { instance().flush(); });
+        return writer;
+    }();
+    return *writer;
+}
+
+bool LogWriter::push(bool error, std::string&& text)
+{
+    size_t position = push_position.load(std::memory_order_relaxed);
+    Slot* slot;
+    while (true)
+    {
+        slot = &slots[position % capacity];
+        size_t sequence = slot->sequence.load(std::memory_order_acquire);
+        if (sequence == position)
+        {
+            if (push_position.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+            {
+                break;
+            }
+        }
+        else if (sequence < position)
+        {
+            // The slot still holds the line pushed one lap ago.
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        else
+        {
+            position = push_position.load(std::memory_order_relaxed);
+        }
+    }
+    slot->error = error;
+    slot->text = std::move(text);
+    slot->sequence.store(position + 1, std::memory_order_release);
+    pushed.fetch_add(1, std::memory_order_release);
+    pushed.notify_one();
+    return true;
+}
+
+void LogWriter::flush()
+{
+    size_t target = push_position.load(std::memory_order_acquire);
+    for (size_t done = written.load(std::memory_order_acquire); done < target; done = written.load(std::memory_order_acquire))
+    {
+        written.wait(done);
+    }
+}
+
+void LogWriter::work()
+{
+    size_t position = 0;
+    size_t reported_drops = 0;
+    while (true)
+    {
+        size_t seen = pushed.load(std::memory_order_acquire);
+        // Write what is ready in one batch and flush the streams once for all of it.
+        size_t batch_end = position + capacity;
+        for (; position < batch_end; position++)
+        {
+            Slot& slot = slots[position % capacity];
+            if (slot.sequence.load(std::memory_order_acquire) != position + 1)
+            {
+                break;
+            }
+            (slot.error? std::cerr: std::cout) << slot.text << '\n';
+            slot.text.clear();
+            slot.sequence.store(position + capacity, std::memory_order_release);
+        }
+        if (size_t drops = dropped.load(std::memory_order_relaxed); drops != reported_drops)
+        {
+            std::cerr << "[Logger]: " << drops - reported_drops << " lines dropped, the log ring was full.\n";
+            reported_drops = drops;
+        }
+        std::cout.flush();
+        std::cerr.flush();
+        written.store(position, std::memory_order_release);
+        written.notify_all();
+        if (position < batch_end)
+        {
+            pushed.wait(seen, std::memory_order_acquire);
+        }
+    }
+}
\ No newline at end of file
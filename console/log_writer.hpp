@@ -0,0 +1,36 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <string>
+
+// Hands formatted log lines from any thread to one background writer through a bounded lock-free ring, so
+// logging never waits on the terminal. Lines pushed while the ring is full are dropped and counted, the
+// writer reports the count once it catches up.
+class LogWriter
+{
+    struct Slot
+    {
+        // The position that may push into the slot next, one past it once that line is ready to write.
+        std::atomic<size_t> sequence;
+        bool error;
+        std::string text;
+    };
+    inline static const size_t capacity = 4096;
+    const std::unique_ptr<Slot[]> slots;
+    std::atomic<size_t> push_position = 0;
+    // Bumped after every push for the writer to wait on.
+    std::atomic<size_t> pushed = 0;
+    // Lines written and flushed to their streams so far.
+    std::atomic<size_t> written = 0;
+    std::atomic<size_t> dropped = 0;
+    LogWriter();
+    void work();
+public:
+    static LogWriter& instance();
+    // Queue a line for `std::cerr` when `error` is set, `std::cout` otherwise. False, leaving the line
+    // untouched, when it was dropped.
+    bool push(bool error, std::string&&);
+    // Wait until every line pushed so far is written. Also runs at exit, so `exit(-1)` loses no errors.
+    void flush();
+};
\ No newline at end of file
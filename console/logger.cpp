@@ -1,8 +1,24 @@
 #include "logger.hpp"
+#include "log_writer.hpp"
 
-void Logger::print(std::ostream& os, const std::string& log_type, const std::string& content) const
+void Logger::print(bool error, const std::string& log_type, const std::string& content) const
 {
-    os << std::format("{}[{}]: {}\033[0m", log_type, module_name, content) << std::endl;
+    auto& writer = LogWriter::instance();
+    std::string line = std::format("{}[{}]: {}\033[0m", log_type, module_name, content);
+    if (error)
+    {
+        // Errors are usually followed by `exit(-1)`; one that finds the ring full is written directly.
+        if (!writer.push(true, std::move(line)))
+        {
+            writer.flush();
+            std::cerr << line << std::endl;
+        }
+        writer.flush();
+    }
+    else
+    {
+        writer.push(false, std::move(line));
+    }
 }
 
 Logger::Logger(const std::string& name): module_name(name)
@@ -3,11 +3,17 @@
 #include <iostream>
 #include <format>
 
+// Most verbose level compiled in, set by the RAYTRACER_LOG_LEVEL CMake option.
+#ifndef RAYTRACER_LOG_LEVEL
+#define RAYTRACER_LOG_LEVEL TRACE
+#endif
+
 class Logger
 {
     inline static const bool stdio_sync = std::ios::sync_with_stdio(false);
     const std::string module_name;
-    void print(std::ostream&, const std::string&, const std::string&) const;
+    // Queue the line for the background `LogWriter`, errors wait until they are written.
+    void print(bool, const std::string&, const std::string&) const;
 public:
     enum LogLevel
     {
@@ -17,32 +23,43 @@ public:
         TRACE
     };
     Logger(const std::string&);
+    // Calls above `compiled_level` compile to nothing, `log_level` filters the rest at run time.
+    inline static constexpr LogLevel compiled_level = RAYTRACER_LOG_LEVEL;
     inline static LogLevel log_level = INFO;
 
     template <typename... Args>
     void error(std::format_string<Args...> fmt_str, Args&&... args) const
     {
-        if (log_level >= ERROR)
+        if constexpr (compiled_level >= ERROR)
         {
-            print(std::cerr, "\033[1m\033[31m[ERROR]", std::format(fmt_str, std::forward<Args>(args)...));
+            if (log_level >= ERROR)
+            {
+                print(true, "\033[1m\033[31m[ERROR]", std::format(fmt_str, std::forward<Args>(args)...));
+            }
         }
     }
     
     template <typename... Args>
     void info(std::format_string<Args...> fmt_str, Args&&... args) const
     {
-        if (log_level >= INFO)
+        if constexpr (compiled_level >= INFO)
         {
-            print(std::cout, "[INFO]", std::format(fmt_str, std::forward<Args>(args)...));
+            if (log_level >= INFO)
+            {
+                print(false, "[INFO]", std::format(fmt_str, std::forward<Args>(args)...));
+            }
         }
     }
 
     template <typename... Args>
     void trace(std::format_string<Args...> fmt_str, Args&&... args) const
     {
-        if (log_level >= TRACE)
+        if constexpr (compiled_level >= TRACE)
         {
-            print(std::cout, "\033[2m\033[30m[TRACE]", std::format(fmt_str, std::forward<Args>(args)...));
+            if (log_level >= TRACE)
+            {
+                print(false, "\033[2m\033[30m[TRACE]", std::format(fmt_str, std::forward<Args>(args)...));
+            }
         }
     }
 };
\ No newline at end of file
@@ -0,0 +1,271 @@
+#include "farm.hpp"
+
+#include <algorithm>
+#include <poll.h>
+#include <spawn.h>
+#include <sys/wait.h>
+#include <stb/stb_image_write.h>
+
+extern char** environ;
+
+Coordinator::Coordinator(Scene& scene, const FarmSettings& settings):
+    settings(settings),
+    width(scene.window_size[0]),
+    height(scene.window_size[1]),
+    limits{0, 0, sizeof(uint32_t) + sizeof(uint64_t) + (uint64_t)settings.tile_size * settings.tile_size * 3 * sizeof(float), 0},
+    image((size_t)width * height * 3, 0.f)
+{
+    std::vector<GLubyte> altas = scene.pack_altas();
+    TextureCube<> tex_cube(scene.build_cube_array<>());
+
+    Message scene_message(Message::SCENE);
+    scene_message.write<int32_t>(width);
+    scene_message.write<int32_t>(height);
+    scene_message.write<int32_t>(settings.tile_size);
+    scene_message.write<float>(scene.camera.position[0]);
+    scene_message.write<float>(scene.camera.position[1]);
+    scene_message.write<float>(scene.camera.position[2]);
+    scene_message.write<float>(scene.camera.orientation[1]);
+    scene_message.write<float>(scene.camera.orientation[0]);
+    scene_message.write<float>(scene.camera.fov);
+    scene_message.write<float>(scene.camera.d);
+    scene_message.write<int32_t>(scene.altas_width);
+    scene_message.write<int32_t>(scene.altas_height);
+    scene_message.write(altas);
+    scene_message.write(tex_cube.records);
+    scene_bytes = std::make_shared<const std::vector<unsigned char>>(scene_message.encode());
+
+    uint32_t id = 0;
+    for (int y = 0; y < height; y += settings.tile_size)
+    {
+        for (int x = 0; x < width; x += settings.tile_size)
+        {
+            for (int pass = 0; pass < settings.passes; pass += settings.passes_per_job)
+            {
+                jobs.push_back({RenderJob{
+                    id,
+                    x, y,
+                    std::min(settings.tile_size, width - x),
+                    std::min(settings.tile_size, height - y),
+                    pass,
+                    std::min(settings.passes_per_job, settings.passes - pass)
+                }});
+                pending.push_back(id++);
+            }
+        }
+    }
+    farmLogger.info("Scene of {} cubes split into {} jobs, {} bytes to ship to each worker.", tex_cube.size(), jobs.size(), scene_bytes->size());
+}
+
+pid_t Coordinator::spawn_local_worker(size_t index) const
+{
+    std::string address = std::format("localhost:{}", settings.port);
+    const char* argv[] = {"/proc/self/exe", "--worker", address.c_str(), nullptr};
+    pid_t pid;
+    if (posix_spawn(&pid, argv[0], nullptr, nullptr, const_cast<char**>(argv), environ) != 0)
+    {
+        farmLogger.error("Failed to spawn local worker {}.", index);
+        return -1;
+    }
+    farmLogger.info("Spawned local worker {} as process {}.", index, pid);
+    return pid;
+}
+
+void Coordinator::reap_local_workers(bool wait)
+{
+    for (size_t i = 0; i < local_workers.size(); i++)
+    {
+        pid_t& pid = local_workers[i];
+        int status;
+        if (pid < 0 || waitpid(pid, &status, wait? 0: WNOHANG) != pid)
+        {
+            continue;
+        }
+        farmLogger.info("Local worker {} (process {}) exited with status {}.", i, pid, WIFEXITED(status)? WEXITSTATUS(status): -WTERMSIG(status));
+        pid = -1;
+        // Its connection drops as well, which puts its job back in the queue.
+        if (!wait && completed < jobs.size() && respawns < settings.local_workers * settings.max_retries)
+        {
+            respawns++;
+            pid = spawn_local_worker(i);
+        }
+    }
+}
+
+void Coordinator::assign(Peer& peer)
+{
+    // A worker still taking the scene gets its job once that is out, so the job timeout counts rendering only.
+    if (peer.job || pending.empty() || peer.writer.pending())
+    {
+        return;
+    }
+    size_t index = pending.front();
+    pending.pop_front();
+    Message message(Message::JOB);
+    message.write(jobs[index].job);
+    peer.job = index;
+    peer.since = std::chrono::steady_clock::now();
+    peer.writer.push(message);
+}
+
+void Coordinator::fail(Peer& peer, const std::string& reason)
+{
+    farmLogger.error("Dropping worker: {}.", reason);
+    if (peer.job)
+    {
+        Job& job = jobs[*peer.job];
+        if (++job.attempts > settings.max_retries)
+        {
+            farmLogger.error("Job {} failed {} times, giving up.", job.job.id, job.attempts);
+            exit(-1);
+        }
+        pending.push_front(*peer.job);
+        peer.job.reset();
+    }
+    peer.socket = Socket();
+}
+
+bool Coordinator::merge(Peer& peer, const Message& message)
+{
+    if (message.type != Message::RESULT || !peer.job)
+    {
+        return false;
+    }
+    const RenderJob& job = jobs[*peer.job].job;
+    uint32_t id = message.read<uint32_t>();
+    std::vector<float> radiance = message.read_vector<float>();
+    if (!message.intact() || id != job.id || radiance.size() != (size_t)job.width * job.height * 3)
+    {
+        return false;
+    }
+    for (int row = 0; row < job.height; row++)
+    {
+        float* target = image.data() + ((size_t)(job.y + row) * width + job.x) * 3;
+        const float* source = radiance.data() + (size_t)row * job.width * 3;
+        for (int i = 0; i < job.width * 3; i++)
+        {
+            target[i] += source[i] * job.pass_count;
+        }
+    }
+    peer.job.reset();
+    completed++;
+    size_t percent = completed * 100 / jobs.size();
+    if (percent != (completed - 1) * 100 / jobs.size())
+    {
+        farmLogger.info("{}% rendered ({}/{} jobs, {} workers).", percent, completed, jobs.size(), peers.size());
+    }
+    return true;
+}
+
+void Coordinator::write_image() const
+{
+    std::vector<unsigned char> pixels((size_t)width * height * 3);
+    for (int row = 0; row < height; row++)
+    {
+        // Framebuffer rows start at the bottom, image files at the top.
+        const float* source = image.data() + (size_t)(height - 1 - row) * width * 3;
+        unsigned char* target = pixels.data() + (size_t)row * width * 3;
+        for (int i = 0; i < width * 3; i++)
+        {
+            target[i] = std::clamp(source[i] / settings.passes, 0.f, 1.f) * 255.f + 0.5f;
+        }
+    }
+    if (!stbi_write_png(settings.output.c_str(), width, height, 3, pixels.data(), width * 3))
+    {
+        farmLogger.error("Failed to write image {}.", settings.output.string());
+        exit(-1);
+    }
+    farmLogger.info("Image written to {}.", settings.output.string());
+}
+
+void Coordinator::run()
+{
+    Socket listener = Socket::listen(settings.port);
+    farmLogger.info("Coordinator listening on port {}.", settings.port);
+    for (int i = 0; i < settings.local_workers; i++)
+    {
+        local_workers.push_back(spawn_local_worker(i));
+    }
+
+    auto last_worker_seen = std::chrono::steady_clock::now();
+    while (completed < jobs.size())
+    {
+        reap_local_workers(false);
+        std::vector<pollfd> fds{{listener.handle(), POLLIN, 0}};
+        for (const auto& peer: peers)
+        {
+            fds.push_back({peer.socket.handle(), (short)(POLLIN | (peer.writer.pending()? POLLOUT: 0)), 0});
+        }
+        if (poll(fds.data(), fds.size(), 1000) < 0)
+        {
+            continue;
+        }
+
+        if (fds[0].revents & POLLIN)
+        {
+            Socket socket = listener.accept();
+            if (socket.valid())
+            {
+                peers.push_back({std::move(socket), MessageReader(limits)});
+                // The scene goes out as the worker takes it, a slow link holds up nobody but itself.
+                peers.back().writer.push(scene_bytes);
+                farmLogger.info("Worker connected, {} workers.", peers.size());
+            }
+        }
+
+        auto now = std::chrono::steady_clock::now();
+        for (size_t i = 1; i < fds.size(); i++)
+        {
+            Peer& peer = peers[i - 1];
+            if (fds[i].revents & (POLLIN | POLLHUP | POLLERR))
+            {
+                // Only what has arrived is read, a worker stalling mid-message holds up nobody but itself.
+                std::optional<Message> message;
+                auto status = peer.reader.read(peer.socket, message);
+                if (status == MessageReader::FAILED)
+                {
+                    fail(peer, "connection lost or malformed message");
+                }
+                else if (status == MessageReader::COMPLETE && !merge(peer, *message))
+                {
+                    fail(peer, "unexpected message");
+                }
+            }
+            if (peer.socket.valid() && (fds[i].revents & POLLOUT) && !peer.writer.write(peer.socket))
+            {
+                fail(peer, "connection lost while sending");
+            }
+            if (peer.socket.valid() && peer.job && now - peer.since > settings.job_timeout)
+            {
+                fail(peer, std::format("job {} timed out", jobs[*peer.job].job.id));
+            }
+        }
+        std::erase_if(peers, [](const Peer& peer) { return !peer.socket.valid(); });
+
+        if (!peers.empty())
+        {
+            last_worker_seen = now;
+        }
+        else if (now - last_worker_seen > settings.worker_timeout)
+        {
+            farmLogger.error("No worker connected for {} s with {} of {} jobs left.", settings.worker_timeout.count(), jobs.size() - completed, jobs.size());
+            exit(-1);
+        }
+
+        for (auto& peer: peers)
+        {
+            assign(peer);
+        }
+    }
+
+    for (const auto& peer: peers)
+    {
+        // A worker that connected late may still be taking the scene; it is just disconnected.
+        if (!peer.writer.pending())
+        {
+            Message(Message::SHUTDOWN).send(peer.socket);
+        }
+    }
+    write_image();
+    reap_local_workers(true);
+}
\ No newline at end of file
@@ -0,0 +1,80 @@
+#pragma once
+
+#include "message.hpp"
+#include "../model/scene.hpp"
+
+#include <chrono>
+#include <deque>
+
+// Image tile and range of passes (frame indices of the sampling sequence) handed to one worker.
+struct RenderJob
+{
+    uint32_t id;
+    int32_t x, y, width, height;
+    int32_t first_pass, pass_count;
+};
+
+struct FarmSettings
+{
+    fs::path output;
+    uint16_t port = 5140;
+    int local_workers = 0;
+    int passes = 64;
+    int passes_per_job = 16;
+    int tile_size = 128;
+    int max_retries = 3;
+    std::chrono::seconds job_timeout{600};
+    // How long the coordinator runs with no worker connected before it gives up.
+    std::chrono::seconds worker_timeout{60};
+};
+
+class Coordinator
+{
+    struct Job
+    {
+        RenderJob job;
+        int attempts = 0;
+    };
+
+    struct Peer
+    {
+        Socket socket;
+        MessageReader reader;
+        MessageWriter writer{};
+        std::optional<size_t> job{};
+        std::chrono::steady_clock::time_point since{};
+    };
+
+    const FarmSettings settings;
+    const int width, height;
+    // Workers only send results, each at most one tile of radiance.
+    const Message::Limits limits;
+    // Encoded once, queued for every worker that connects.
+    std::shared_ptr<const std::vector<unsigned char>> scene_bytes;
+    std::vector<Job> jobs;
+    std::deque<size_t> pending;
+    std::vector<Peer> peers;
+    size_t completed = 0;
+    std::vector<float> image;
+    // Processes of the local workers, -1 once reaped; each may be respawned up to `max_retries` times.
+    std::vector<pid_t> local_workers;
+    int respawns = 0;
+
+    pid_t spawn_local_worker(size_t) const;
+    void reap_local_workers(bool wait);
+    void assign(Peer&);
+    void fail(Peer&, const std::string&);
+    bool merge(Peer&, const Message&);
+    void write_image() const;
+public:
+    Coordinator(Scene&, const FarmSettings&);
+    void run();
+};
+
+class Worker
+{
+    const Socket socket;
+public:
+    Worker(const std::string&);
+    void run();
+};
\ No newline at end of file
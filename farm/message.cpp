@@ -0,0 +1,152 @@
+#include "message.hpp"
+
+Message::Message(Type type): type(type)
+{}
+
+size_t Message::size() const
+{
+    return payload.size();
+}
+
+bool Message::intact() const
+{
+    return !overrun;
+}
+
+bool Message::send(const Socket& socket) const
+{
+    struct
+    {
+        uint32_t type;
+        uint64_t size;
+    } header{type, payload.size()};
+    return socket.send(&header.type, sizeof(header.type))
+        && socket.send(&header.size, sizeof(header.size))
+        && socket.send(payload.data(), payload.size());
+}
+
+std::vector<unsigned char> Message::encode() const
+{
+    Message header(type);
+    header.write<uint32_t>(type);
+    header.write<uint64_t>(payload.size());
+    std::vector<unsigned char> bytes = std::move(header.payload);
+    bytes.insert(bytes.end(), payload.begin(), payload.end());
+    return bytes;
+}
+
+static bool within_limits(uint32_t type, uint64_t size, const Message::Limits& limits)
+{
+    if (type > Message::SHUTDOWN)
+    {
+        farmLogger.info("Received a message of unknown type {}.", type);
+        return false;
+    }
+    if (size > limits[type])
+    {
+        farmLogger.info("Received a message of type {} with {} bytes, over the limit of {}.", type, size, limits[type]);
+        return false;
+    }
+    return true;
+}
+
+std::optional<Message> Message::receive(const Socket& socket, const Limits& limits)
+{
+    uint32_t type;
+    uint64_t size;
+    if (!socket.receive(&type, sizeof(type)) || !socket.receive(&size, sizeof(size)) || !within_limits(type, size, limits))
+    {
+        return std::nullopt;
+    }
+    Message message(static_cast<Type>(type));
+    message.payload.resize(size);
+    if (!socket.receive(message.payload.data(), size))
+    {
+        return std::nullopt;
+    }
+    return message;
+}
+
+MessageReader::MessageReader(const Message::Limits& limits): limits(limits)
+{}
+
+MessageReader::Status MessageReader::read(const Socket& socket, std::optional<Message>& result)
+{
+    if (header_read < header_size)
+    {
+        long received = socket.receive_available(header + header_read, header_size - header_read);
+        if (received < 0)
+        {
+            return FAILED;
+        }
+        header_read += received;
+        if (header_read < header_size)
+        {
+            return PENDING;
+        }
+        uint32_t type;
+        uint64_t size;
+        std::memcpy(&type, header, sizeof(type));
+        std::memcpy(&size, header + sizeof(type), sizeof(size));
+        if (!within_limits(type, size, limits))
+        {
+            return FAILED;
+        }
+        message.emplace(static_cast<Message::Type>(type));
+        message->payload.resize(size);
+        payload_read = 0;
+    }
+    if (payload_read < message->payload.size())
+    {
+        long received = socket.receive_available(message->payload.data() + payload_read, message->payload.size() - payload_read);
+        if (received < 0)
+        {
+            return FAILED;
+        }
+        payload_read += received;
+        if (payload_read < message->payload.size())
+        {
+            return PENDING;
+        }
+    }
+    result = std::move(message);
+    message.reset();
+    header_read = 0;
+    return COMPLETE;
+}
+
+void MessageWriter::push(const Message& message)
+{
+    push(std::make_shared<const std::vector<unsigned char>>(message.encode()));
+}
+
+void MessageWriter::push(std::shared_ptr<const std::vector<unsigned char>> bytes)
+{
+    queue.push_back(std::move(bytes));
+}
+
+bool MessageWriter::pending() const
+{
+    return !queue.empty();
+}
+
+bool MessageWriter::write(const Socket& socket)
+{
+    while (!queue.empty())
+    {
+        const std::vector<unsigned char>& bytes = *queue.front();
+        long written = socket.send_available(bytes.data() + sent, bytes.size() - sent);
+        if (written < 0)
+        {
+            return false;
+        }
+        sent += written;
+        if (sent < bytes.size())
+        {
+            return true;
+        }
+        queue.pop_front();
+        sent = 0;
+    }
+    return true;
+}
\ No newline at end of file
@@ -0,0 +1,127 @@
+#pragma once
+
+#include "socket.hpp"
+
+#include <array>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <optional>
+#include <type_traits>
+#include <vector>
+
+// Every host of a farm is expected to share the byte order, payloads are raw memory images.
+class Message
+{
+    std::vector<unsigned char> payload;
+    mutable size_t cursor = 0;
+    mutable bool overrun = false;
+    friend class MessageReader;
+public:
+    enum Type: uint32_t
+    {
+        SCENE,
+        JOB,
+        RESULT,
+        SHUTDOWN
+    };
+    Type type;
+    // Largest payload accepted per type, so a corrupt or hostile header cannot make the receiver allocate
+    // without bound; 0 for the types a side does not expect.
+    using Limits = std::array<uint64_t, SHUTDOWN + 1>;
+
+    Message(Type);
+
+    template <typename T>
+        requires std::is_trivially_copyable_v<T>
+    void write(const T& value)
+    {
+        const unsigned char* bytes = reinterpret_cast<const unsigned char*>(&value);
+        payload.insert(payload.end(), bytes, bytes + sizeof(T));
+    }
+
+    template <typename T>
+        requires std::is_trivially_copyable_v<T>
+    void write(const std::vector<T>& values)
+    {
+        write((uint64_t)values.size());
+        const unsigned char* bytes = reinterpret_cast<const unsigned char*>(values.data());
+        payload.insert(payload.end(), bytes, bytes + values.size() * sizeof(T));
+    }
+
+    template <typename T>
+        requires std::is_trivially_copyable_v<T>
+    T read() const
+    {
+        T value{};
+        if (cursor + sizeof(T) > payload.size())
+        {
+            overrun = true;
+            return value;
+        }
+        std::memcpy(&value, payload.data() + cursor, sizeof(T));
+        cursor += sizeof(T);
+        return value;
+    }
+
+    template <typename T>
+        requires std::is_trivially_copyable_v<T>
+    std::vector<T> read_vector() const
+    {
+        uint64_t size = read<uint64_t>();
+        if (overrun || size > (payload.size() - cursor) / sizeof(T))
+        {
+            overrun = true;
+            return {};
+        }
+        std::vector<T> values(size);
+        std::memcpy(values.data(), payload.data() + cursor, size * sizeof(T));
+        cursor += size * sizeof(T);
+        return values;
+    }
+
+    size_t size() const;
+    // False once a read ran past the end of the payload.
+    bool intact() const;
+    bool send(const Socket&) const;
+    // Header and payload as they go on the wire.
+    std::vector<unsigned char> encode() const;
+    // Blocks until a whole message arrived; nothing if the peer is gone or the payload is over its limit.
+    static std::optional<Message> receive(const Socket&, const Limits&);
+};
+
+// Assembles messages from whatever a socket has available, for poll loops that must not wait on one peer.
+class MessageReader
+{
+    inline static const size_t header_size = sizeof(uint32_t) + sizeof(uint64_t);
+    Message::Limits limits;
+    unsigned char header[header_size];
+    size_t header_read = 0;
+    std::optional<Message> message;
+    size_t payload_read = 0;
+public:
+    enum Status
+    {
+        PENDING,
+        COMPLETE,
+        FAILED
+    };
+    explicit MessageReader(const Message::Limits&);
+    // Read what arrived; on COMPLETE `result` holds the message and the next one starts. FAILED when the peer
+    // is gone or sent a header over the limits.
+    Status read(const Socket&, std::optional<Message>& result);
+};
+
+// Queues messages for a peer and sends them as its socket accepts data, the counterpart of MessageReader.
+class MessageWriter
+{
+    // Encoded messages are shared, so one scene can be queued for every worker without a copy each.
+    std::deque<std::shared_ptr<const std::vector<unsigned char>>> queue;
+    size_t sent = 0;
+public:
+    void push(const Message&);
+    void push(std::shared_ptr<const std::vector<unsigned char>>);
+    bool pending() const;
+    // Send what the socket takes; false once the peer is gone.
+    bool write(const Socket&);
+};
\ No newline at end of file
@@ -0,0 +1,163 @@
+#include "socket.hpp"
+
+#include <cerrno>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+Socket::Socket(int fd): fd(fd)
+{}
+
+Socket::Socket(Socket&& other) noexcept: fd(other.fd)
+{
+    other.fd = -1;
+}
+
+Socket& Socket::operator=(Socket&& other) noexcept
+{
+    if (this != &other)
+    {
+        if (fd >= 0)
+        {
+            close(fd);
+        }
+        fd = other.fd;
+        other.fd = -1;
+    }
+    return *this;
+}
+
+Socket Socket::connect(const std::string& host, uint16_t port)
+{
+    addrinfo hints{};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo* addresses;
+    int status = getaddrinfo(host.c_str(), std::to_string(port).c_str(), &hints, &addresses);
+    if (status != 0)
+    {
+        farmLogger.error("Cannot resolve {}: {}.", host, gai_strerror(status));
+        return Socket();
+    }
+    Socket result;
+    for (addrinfo* address = addresses; address; address = address->ai_next)
+    {
+        Socket candidate(socket(address->ai_family, address->ai_socktype, address->ai_protocol));
+        if (candidate.valid() && ::connect(candidate.fd, address->ai_addr, address->ai_addrlen) == 0)
+        {
+            int flag = 1;
+            setsockopt(candidate.fd, IPPROTO_TCP, TCP_NODELAY, &flag, sizeof(flag));
+            result = std::move(candidate);
+            break;
+        }
+    }
+    freeaddrinfo(addresses);
+    return result;
+}
+
+Socket Socket::listen(uint16_t port)
+{
+    Socket listener(socket(AF_INET6, SOCK_STREAM, 0));
+    if (!listener.valid())
+    {
+        farmLogger.error("Failed to create listening socket.");
+        exit(-1);
+    }
+    int flag = 1;
+    setsockopt(listener.fd, SOL_SOCKET, SO_REUSEADDR, &flag, sizeof(flag));
+    flag = 0;
+    setsockopt(listener.fd, IPPROTO_IPV6, IPV6_V6ONLY, &flag, sizeof(flag));
+    sockaddr_in6 address{};
+    address.sin6_family = AF_INET6;
+    address.sin6_addr = in6addr_any;
+    address.sin6_port = htons(port);
+    if (bind(listener.fd, (sockaddr*)&address, sizeof(address)) != 0 || ::listen(listener.fd, SOMAXCONN) != 0)
+    {
+        farmLogger.error("Failed to listen on port {}.", port);
+        exit(-1);
+    }
+    return listener;
+}
+
+Socket Socket::accept() const
+{
+    Socket peer(::accept(fd, nullptr, nullptr));
+    if (peer.valid())
+    {
+        int flag = 1;
+        setsockopt(peer.fd, IPPROTO_TCP, TCP_NODELAY, &flag, sizeof(flag));
+    }
+    return peer;
+}
+
+bool Socket::valid() const
+{
+    return fd >= 0;
+}
+
+int Socket::handle() const
+{
+    return fd;
+}
+
+bool Socket::send(const void* data, size_t size) const
+{
+    const char* bytes = static_cast<const char*>(data);
+    while (size)
+    {
+        ssize_t sent = ::send(fd, bytes, size, MSG_NOSIGNAL);
+        if (sent <= 0)
+        {
+            return false;
+        }
+        bytes += sent;
+        size -= sent;
+    }
+    return true;
+}
+
+bool Socket::receive(void* data, size_t size) const
+{
+    char* bytes = static_cast<char*>(data);
+    while (size)
+    {
+        ssize_t received = recv(fd, bytes, size, 0);
+        if (received <= 0)
+        {
+            return false;
+        }
+        bytes += received;
+        size -= received;
+    }
+    return true;
+}
+
+long Socket::receive_available(void* data, size_t size) const
+{
+    ssize_t received = recv(fd, data, size, MSG_DONTWAIT);
+    if (received < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR))
+    {
+        return 0;
+    }
+    return received > 0? received: -1;
+}
+
+long Socket::send_available(const void* data, size_t size) const
+{
+    ssize_t sent = ::send(fd, data, size, MSG_DONTWAIT | MSG_NOSIGNAL);
+    if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR))
+    {
+        return 0;
+    }
+    return sent > 0? sent: -1;
+}
+
+Socket::~Socket()
+{
+    if (fd >= 0)
+    {
+        close(fd);
+    }
+}
\ No newline at end of file
@@ -0,0 +1,34 @@
+#pragma once
+
+#include "../console/logger.hpp"
+
+#include <cstdint>
+#include <string>
+
+inline Logger farmLogger{"Farm"};
+
+// Blocking TCP stream; failures are reported to the caller so a lost peer can be recovered from.
+class Socket
+{
+    int fd;
+public:
+    explicit Socket(int = -1);
+    Socket(Socket&&) noexcept;
+    Socket& operator=(Socket&&) noexcept;
+    Socket(const Socket&) = delete;
+    Socket& operator=(const Socket&) = delete;
+    static Socket connect(const std::string&, uint16_t);
+    static Socket listen(uint16_t);
+    Socket accept() const;
+    bool valid() const;
+    int handle() const;
+    bool send(const void*, size_t) const;
+    bool receive(void*, size_t) const;
+    // Read what has arrived, up to `size` bytes, without blocking: the byte count, 0 if nothing is there yet,
+    // -1 once the peer is gone.
+    long receive_available(void*, size_t) const;
+    // Write what fits in the send buffer, up to `size` bytes, without blocking: the byte count, 0 if the buffer
+    // is full, -1 once the peer is gone.
+    long send_available(const void*, size_t) const;
+    ~Socket();
+};
\ No newline at end of file
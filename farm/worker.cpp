@@ -0,0 +1,136 @@
+#include "farm.hpp"
+
+#include "../view/raytrace.hpp"
+#include "../view/temporal.hpp"
+
+#include <SDL2/SDL.h>
+#include <thread>
+
+static Socket connect_to(const std::string& address)
+{
+    size_t colon = address.rfind(':');
+    if (colon == std::string::npos)
+    {
+        farmLogger.error("Coordinator address {} is not of the form HOST:PORT.", address);
+        exit(-1);
+    }
+    std::string host = address.substr(0, colon);
+    uint16_t port = std::stoi(address.substr(colon + 1));
+    // The coordinator may still be starting up, typically when it spawned this worker itself.
+    for (int attempt = 0; attempt < 50; attempt++)
+    {
+        Socket socket = Socket::connect(host, port);
+        if (socket.valid())
+        {
+            return socket;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+    farmLogger.error("Cannot connect to coordinator {}.", address);
+    exit(-1);
+}
+
+// The coordinator sends the scene once, then jobs and finally a shutdown.
+static const Message::Limits worker_limits{1ull << 32, sizeof(RenderJob), 0, 0};
+
+Worker::Worker(const std::string& address):
+    socket(connect_to(address))
+{}
+
+void Worker::run()
+{
+    std::optional<Message> scene_message = Message::receive(socket, worker_limits);
+    if (!scene_message || scene_message->type != Message::SCENE)
+    {
+        farmLogger.error("Coordinator did not send a scene.");
+        exit(-1);
+    }
+    const Message& scene = *scene_message;
+    int width = scene.read<int32_t>();
+    int height = scene.read<int32_t>();
+    int tile_size = scene.read<int32_t>();
+    float position[3], pitch, yaw, hfov, d;
+    position[0] = scene.read<float>();
+    position[1] = scene.read<float>();
+    position[2] = scene.read<float>();
+    pitch = scene.read<float>();
+    yaw = scene.read<float>();
+    hfov = scene.read<float>();
+    d = scene.read<float>();
+    int altas_width = scene.read<int32_t>();
+    int altas_height = scene.read<int32_t>();
+    std::vector<GLubyte> altas_pixels = scene.read_vector<GLubyte>();
+    TextureCube<> tex_cube;
+    tex_cube.records = scene.read_vector<GLuint>();
+    if (!scene.intact() || altas_pixels.size() != (size_t)altas_width * altas_height * 4 || tex_cube.records.size() % (TextureCube<>::texels_per_cube * 4))
+    {
+        farmLogger.error("Received a malformed scene.");
+        exit(-1);
+    }
+    Camera camera{position[0], position[1], position[2], pitch, yaw, hfov, d, 0, 0, 0, 0, 0};
+
+    SDL_Window* window = SDL_CreateWindow("RayTrace worker", 0, 0, 1, 1, SDL_WINDOW_OPENGL | SDL_WINDOW_HIDDEN);
+    SDL_GLContext gl_context = window? SDL_GL_CreateContext(window): NULL;
+    if (gl_context == NULL)
+    {
+        farmLogger.error("Failed to create GL context: {}.", SDL_GetError());
+        exit(-1);
+    }
+
+    {
+        Texture altas{};
+        altas.allocate(altas_width, altas_height, GL_RGBA8);
+        altas.buffer(0, 0, altas_width, altas_height, GL_RGBA, altas_pixels.data());
+
+        Program prog("../shaders/raytrace/vertex.glsl", "../shaders/raytrace/fragment.glsl", GL_TRIANGLES);
+        RayTraceScene raytrace_scene(tex_cube, altas);
+        raytrace_scene.attach(prog);
+        TemporalAccumulator accumulator(tile_size, tile_size);
+        FrameBlock frame;
+        farmLogger.info("Scene of {} cubes received, rendering {}x{} image.", tex_cube.size(), width, height);
+
+        std::vector<float> radiance;
+        while (true)
+        {
+            std::optional<Message> message = Message::receive(socket, worker_limits);
+            if (!message || message->type == Message::SHUTDOWN)
+            {
+                break;
+            }
+            RenderJob job = message->read<RenderJob>();
+            if (message->type != Message::JOB || !message->intact() || job.width > tile_size || job.height > tile_size)
+            {
+                farmLogger.error("Received a malformed job.");
+                break;
+            }
+
+            // The whole image is mapped onto the tile-sized target so that only this tile lands inside it.
+            accumulator.reset(job.first_pass);
+            const Framebuffer* output = nullptr;
+            for (int pass = 0; pass < job.pass_count; pass++)
+            {
+                accumulator.begin(prog, frame, camera);
+                glViewport(-job.x, -job.y, width, height);
+                frame.set_camera(camera);
+                frame.upload();
+                prog.draw();
+                output = &accumulator.end(camera, -job.x, -job.y, width, height);
+            }
+            radiance.resize((size_t)job.width * job.height * 3);
+            output->read(0, 0, 0, job.width, job.height, GL_RGB, radiance.data());
+            output->unbind();
+
+            Message result(Message::RESULT);
+            result.write(job.id);
+            result.write(radiance);
+            if (!result.send(socket))
+            {
+                farmLogger.error("Lost connection to coordinator.");
+                break;
+            }
+        }
+    }
+
+    SDL_GL_DeleteContext(gl_context);
+    SDL_DestroyWindow(window);
+}
\ No newline at end of file
@@ -1,43 +1,312 @@
+#include "farm/farm.hpp"
 #include "model/scene.hpp"
 #include "opengl/shader.hpp"
+#include "view/raytrace.hpp"
 #include "view/sdl.hpp"
 
-int main()
+#include <numbers>
+
+int main(int argc, char* argv[])
 {
     Logger logger{"Main"};
 
+    bool raytrace = false;
+    bool packed = false;
+    bool instanced = false;
+    bool cull = true;
+    bool wavefront = false;
+    int benchmark_frames = 0;
+    std::optional<size_t> turntable;
+    ShaderDefines defines;
+    std::optional<std::string> worker_address;
+    std::optional<fs::path> sequence;
+    std::optional<fs::path> profile;
+    std::optional<FarmSettings> farm;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        auto value = [&]() -> std::string
+        {
+            if (i + 1 >= argc)
+            {
+                logger.error("Argument {} expects a value.", arg);
+                exit(-1);
+            }
+            return argv[++i];
+        };
+        if (arg == "--raytrace")
+        {
+            raytrace = true;
+        }
+        else if (arg == "--packed")
+        {
+            packed = true;
+        }
+        else if (arg == "--instanced")
+        {
+            instanced = true;
+        }
+        else if (arg == "--hybrid")
+        {
+            defines["HYBRID"] = "1";
+        }
+        else if (arg == "--wavefront")
+        {
+            raytrace = wavefront = true;
+        }
+        else if (arg == "--benchmark")
+        {
+            raytrace = true;
+            benchmark_frames = std::stoi(value());
+        }
+        else if (arg == "--turntable")
+        {
+            turntable = std::stoul(value());
+        }
+        else if (arg == "--no-cull")
+        {
+            cull = false;
+        }
+        else if (arg == "--define")
+        {
+            std::string define = value();
+            size_t equals = define.find('=');
+            if (equals == std::string::npos)
+            {
+                logger.error("Argument --define expects NAME=VALUE, got {}.", define);
+                return -1;
+            }
+            defines[define.substr(0, equals)] = define.substr(equals + 1);
+        }
+        else if (arg == "--profile")
+        {
+            profile = value();
+        }
+        else if (arg == "--sequence")
+        {
+            sequence = value();
+        }
+        else if (arg == "--worker")
+        {
+            worker_address = value();
+        }
+        else if (arg == "--render")
+        {
+            farm.emplace().output = value();
+        }
+        else if (farm && arg == "--port")
+        {
+            farm->port = std::stoi(value());
+        }
+        else if (farm && arg == "--workers")
+        {
+            farm->local_workers = std::stoi(value());
+        }
+        else if (farm && arg == "--passes")
+        {
+            farm->passes = std::stoi(value());
+        }
+        else if (farm && arg == "--passes-per-job")
+        {
+            farm->passes_per_job = std::stoi(value());
+        }
+        else if (farm && arg == "--tile")
+        {
+            farm->tile_size = std::stoi(value());
+        }
+        else if (farm && arg == "--worker-timeout")
+        {
+            farm->worker_timeout = std::chrono::seconds(std::stoi(value()));
+        }
+        else
+        {
+            logger.error("Unknown argument {}.", arg);
+            return -1;
+        }
+    }
+
+    // Started before anything loads, so the profile covers startup too.
+    if (profile)
+    {
+        profiler.enable(*profile);
+    }
+
+    if (worker_address)
+    {
+        Worker(*worker_address).run();
+        profiler.finish();
+        return 0;
+    }
+
     auto scene = Scene("../assets/scene.json");
-    SDL_Context window(scene.window_size[0], scene.window_size[1], scene.window_name, {-15, 35, -15, -0.4, 0.75, 1, 1, 0.2, 0.003, 0.02, 0.05, 0.2});
+
+    if (farm)
+    {
+        if (farm->passes <= 0 || farm->passes_per_job <= 0 || farm->tile_size <= 0)
+        {
+            logger.error("Pass counts and tile size must be positive.");
+            return -1;
+        }
+        Coordinator(scene, *farm).run();
+        profiler.finish();
+        return 0;
+    }
+
+    if (sequence && defines.contains("HYBRID"))
+    {
+        logger.error("Hybrid tracing only runs in the interactive loop, not with --sequence.");
+        return -1;
+    }
+    if ((wavefront || benchmark_frames) && defines.contains("HYBRID"))
+    {
+        logger.error("The wavefront tracer has no hybrid mode.");
+        return -1;
+    }
+
+    if (turntable && (raytrace || sequence || instanced || cull))
+    {
+        logger.error("--turntable streams the geometry-shader input, it needs --no-cull and no ray tracing or --instanced.");
+        return -1;
+    }
+    if (turntable && *turntable >= scene.objects.size())
+    {
+        logger.error("--turntable {} is past the last of {} objects.", *turntable, scene.objects.size());
+        return -1;
+    }
+
+    SDL_Context window(scene.window_size[0], scene.window_size[1], scene.window_name, {-15, 35, -15, -0.4, 0.75, 1, 1, 0.2, 0.003, 0.02, 0.05, 0.2}, {(float)scene.target_frame_time, (float)scene.min_render_scale}, scene.screenshot_save_path);
+
+    window.refine_frames = scene.refine_frames;
+
+    profiler.enable_gpu();
 
     // stbi_set_flip_vertically_on_load(true);
 
     Texture altas{};
     scene.gen_altas(altas);
 
-    auto cubes = scene.build_cube_array<>();
+    auto render = [&]<cube_data_type P, cube_data_type T>()
+    {
+        auto cubes = scene.build_cube_array<P, T>();
+
+        if (raytrace || sequence)
+        {
+            RayTraceScene raytrace_scene(TextureCube<P, T>(cubes), altas);
+
+            // Hybrid tracing rasterizes the first hits with the geometry path.
+            std::optional<Program> gbuffer_raster;
+            std::optional<GBuffer> gbuffer;
+            if (defines.contains("HYBRID"))
+            {
+                gbuffer_raster.emplace("../shaders/vertex.glsl", "../shaders/geometry.glsl", "../shaders/gbuffer/fragment.glsl", GL_POINTS, ShaderDefines{{"GBUFFER", "1"}});
+                gbuffer_raster->set_input(cubes);
+                gbuffer_raster->set("altas", altas);
+                gbuffer.emplace(scene.window_size[0], scene.window_size[1], *gbuffer_raster);
+            }
+
+            ProgramVariants variants([&](const ShaderDefines& variant)
+            {
+                auto prog = std::make_unique<Program>("../shaders/raytrace/vertex.glsl", "../shaders/raytrace/fragment.glsl", GL_TRIANGLES, variant);
+                raytrace_scene.attach(*prog);
+                if (gbuffer)
+                {
+                    gbuffer->attach(*prog);
+                }
+                return prog;
+            });
+
+            TemporalAccumulator temporal(scene.window_size[0], scene.window_size[1]);
+
+            std::optional<WavefrontTracer> wavefront_tracer;
+            if (wavefront || benchmark_frames > 0)
+            {
+                wavefront_tracer.emplace(raytrace_scene, scene.window_size[0], scene.window_size[1], defines);
+            }
+
+            if (sequence)
+            {
+                CameraPath path(*sequence);
+                FrameEncoder encoder(scene.window_size[0], scene.window_size[1], path.frame_rate, path.output);
+                window.render_sequence(variants.get(defines), temporal, path, encoder);
+            }
+            else if (benchmark_frames > 0)
+            {
+                window.benchmark(variants.get(defines), temporal, *wavefront_tracer, benchmark_frames);
+            }
+            else
+            {
+                // Cheap paths while the camera moves, temporal accumulation hides the noise.
+                ShaderDefines preview = defines;
+                preview["SAMPLE_COUNT"] = "2";
+                preview["MAX_BOUNCES"] = "3";
+                window.render_loop(variants.get(defines), {
+                    .temporal = &temporal,
+                    .preview = &variants.get(preview),
+                    .gbuffer = gbuffer? &*gbuffer: nullptr,
+                    .wavefront = wavefront? &*wavefront_tracer: nullptr
+                });
+            }
+        }
+        else
+        {
+            std::optional<CubeCuller> culler;
+            if (cull)
+            {
+                culler.emplace(cubes, scene.cube_clusters(), scene.window_size[0], scene.window_size[1]);
+            }
+            CubeCuller* const culler_ptr = culler? &*culler: nullptr;
+
+            if (instanced)
+            {
+                Program prog("../shaders/instanced/vertex.glsl", "../shaders/fragment.glsl", GL_TRIANGLES);
 
-    Program prog("../shaders/vertex.glsl", "../shaders/geometry.glsl", "../shaders/fragment.glsl", GL_POINTS);
+                prog.set_instanced_input(cubes);
 
-    prog.set_input(cubes);
+                prog.set("altas", altas);
 
-    // Program prog("../shaders/raytrace/vertex.glsl", "../shaders/raytrace/fragment.glsl", GL_TRIANGLES);
+                window.render_loop(prog, {.culler = culler_ptr});
+            }
+            else
+            {
+                Program prog("../shaders/vertex.glsl", "../shaders/geometry.glsl", "../shaders/fragment.glsl", GL_POINTS);
 
-    // prog.set_input<>();
+                prog.set_input(cubes, turntable.has_value());
 
-    // Texture ori_size{}, rotation{}, uv{}, material{};
+                prog.set("altas", altas);
 
-    // TextureCube<> tex_cube(cubes);
-    // tex_cube.buffer_to_texture(ori_size, rotation, uv, material);
+                // The turntable object is rebuilt at every simulation step and streamed over its range of the cubes.
+                std::function<void(double)> spin;
+                if (turntable)
+                {
+                    const double period = 10.;
+                    size_t first = 0;
+                    for (const auto& cluster: scene.cube_clusters())
+                    {
+                        first += cluster.object < *turntable? cluster.count: 0;
+                    }
+                    spin = [&, first, spun = CubeArray<P, T>()](double time) mutable
+                    {
+                        spun.clear();
+                        scene.push_object(spun, *turntable, 2 * std::numbers::pi * time / period);
+                        prog.update_input(first, spun);
+                    };
+                }
 
-    // prog.set("cube.origin_size", ori_size);
-    // prog.set("cube.rotation", rotation);
-    // prog.set("cube.uv", uv);
-    // prog.set("cube.material", material);
+                window.render_loop(prog, {.animate = spin, .culler = culler_ptr});
+            }
+        }
+    };
 
-    prog.set("altas", altas);
-    // prog.set("count", (int)cubes.size());
+    if (packed)
+    {
+        render.operator()<GLshort, GLshort>();
+    }
+    else
+    {
+        render.operator()<GLfloat, GLfloat>();
+    }
 
-    window.render_loop(prog, nullptr);
+    profiler.finish();
 
     return 0;
-}
\ No newline at end of file
+}
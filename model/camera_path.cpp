@@ -0,0 +1,103 @@
+#include "camera_path.hpp"
+
+#include "../console/logger.hpp"
+
+#include <cmath>
+#include <fstream>
+#include <json/json.h>
+
+extern Logger modelLogger;
+
+const Json::Value& aquire_array(const Json::Value&, const char* const, int, const fs::path&);
+const Json::Value& aquire_double(const Json::Value&, const char* const, const fs::path&);
+
+CameraPath::CameraPath(const fs::path& path_file)
+{
+    std::ifstream file(path_file);
+    if (!file)
+    {
+        modelLogger.error("Failed to open camera path file: {}.", path_file.string());
+        exit(-1);
+    }
+    Json::Value path_json;
+    file >> path_json;
+    file.close();
+
+    if (!path_json.isObject())
+    {
+        modelLogger.error("Camera path file {} is not a JSON object.", path_file.string());
+        exit(-1);
+    }
+    frame_rate = aquire_double(path_json, "frame_rate", path_file).asDouble();
+    samples = aquire_double(path_json, "samples", path_file).asInt();
+    if (frame_rate <= 0 || samples <= 0)
+    {
+        modelLogger.error("Camera path file {} must have a positive `frame_rate` and `samples`.", path_file.string());
+        exit(-1);
+    }
+    if (!path_json.isMember("output") || !path_json["output"].isString())
+    {
+        modelLogger.error("Camera path file {} does not have a valid `output` field.", path_file.string());
+        exit(-1);
+    }
+    output = path_file.parent_path() / path_json["output"].asString();
+    for (const Json::Value& keyframe_json: aquire_array(path_json, "keyframes", 0, path_file))
+    {
+        if (!keyframe_json.isObject())
+        {
+            modelLogger.error("Camera path file {} have a non-object `keyframes` element.", path_file.string());
+            exit(-1);
+        }
+        Keyframe keyframe;
+        keyframe.time = aquire_double(keyframe_json, "time", path_file).asDouble();
+        const Json::Value& position_json = aquire_array(keyframe_json, "position", 3, path_file);
+        keyframe.position[0] = position_json[0].asDouble();
+        keyframe.position[1] = position_json[1].asDouble();
+        keyframe.position[2] = position_json[2].asDouble();
+        const Json::Value& orientation_json = aquire_array(keyframe_json, "orientation", 2, path_file);
+        keyframe.orientation[0] = orientation_json[0].asDouble();
+        keyframe.orientation[1] = orientation_json[1].asDouble();
+        keyframe.fov = aquire_double(keyframe_json, "fov", path_file).asDouble();
+        if (!keyframes.empty() && keyframe.time <= keyframes.back().time)
+        {
+            modelLogger.error("Keyframe times in camera path file {} are not increasing.", path_file.string());
+            exit(-1);
+        }
+        keyframes.push_back(keyframe);
+    }
+    if (keyframes.empty())
+    {
+        modelLogger.error("Camera path file {} has no keyframes.", path_file.string());
+        exit(-1);
+    }
+}
+
+CameraPath::Keyframe CameraPath::at(double time) const
+{
+    if (time <= keyframes.front().time)
+    {
+        return keyframes.front();
+    }
+    for (size_t i = 1; i < keyframes.size(); i++)
+    {
+        const Keyframe& from = keyframes[i - 1];
+        const Keyframe& to = keyframes[i];
+        if (time < to.time)
+        {
+            double k = (time - from.time) / (to.time - from.time);
+            auto lerp = [k](double a, double b) { return a + (b - a) * k; };
+            return {
+                time,
+                {lerp(from.position[0], to.position[0]), lerp(from.position[1], to.position[1]), lerp(from.position[2], to.position[2])},
+                {lerp(from.orientation[0], to.orientation[0]), lerp(from.orientation[1], to.orientation[1])},
+                lerp(from.fov, to.fov)
+            };
+        }
+    }
+    return keyframes.back();
+}
+
+int CameraPath::frame_count() const
+{
+    return std::floor((keyframes.back().time - keyframes.front().time) * frame_rate) + 1;
+}
\ No newline at end of file
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <filesystem>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+class CameraPath
+{
+public:
+    struct Keyframe
+    {
+        double time;
+        double position[3];
+        double orientation[2];
+        double fov;
+    };
+
+    std::vector<Keyframe> keyframes;
+    double frame_rate;
+    // Ray-trace passes accumulated for every frame.
+    int samples;
+    // A `.y4m` file receives a single video stream, anything else is a directory of numbered PNG frames.
+    fs::path output;
+
+    CameraPath(const fs::path&);
+    Keyframe at(double) const;
+    int frame_count() const;
+};
\ No newline at end of file
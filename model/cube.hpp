@@ -1,29 +1,46 @@
 #pragma once
 
+#include "../opengl/profiler.hpp"
 #include "../opengl/texture.hpp"
 #include "model.hpp"
 #include "pose.hpp"
 
+#include <algorithm>
+#include <array>
 #include <cmath>
 #include <concepts>
+#include <cstring>
+#include <limits>
 
 template <typename T>
 concept gl_floating_point = is_gl_type<T> && std::floating_point<T>;
 
-template <gl_floating_point T>
+// Floating types store cubes as they are, GLshort selects the packed format: snorm16 rotations for
+// positions, atlas texel rects and 4.4 fixed-point material bytes for textures.
+template <typename T>
+concept cube_data_type = gl_floating_point<T> || std::same_as<T, GLshort>;
+
+// 16 bits are too coarse for scene coordinates, so packed cubes keep origin and size in single precision.
+template <cube_data_type T>
+using cube_position_t = std::conditional_t<std::floating_point<T>, T, GLfloat>;
+
+template <cube_data_type T>
+using cube_material_t = std::conditional_t<std::floating_point<T>, T, GLubyte>;
+
+template <cube_data_type T>
 struct _cube_origin_size
 {
-    T origin[3];
-    T size[3];
+    cube_position_t<T> origin[3];
+    cube_position_t<T> size[3];
 };
 
-template <gl_floating_point T>
+template <cube_data_type T>
 struct _cube_rotation
 {
     T rotation[4];
 };
 
-template <gl_floating_point T>
+template <cube_data_type T>
 struct _cube_uv
 {
     T east[4];
@@ -34,78 +51,209 @@ struct _cube_uv
     T down[4];
 };
 
-template <gl_floating_point T>
+template <cube_data_type T>
 struct _cube_material
 {
-    T material[2];
+    cube_material_t<T> material[2];
 };
 
+template <typename T>
+T _quantize(double value)
+{
+    if constexpr (std::floating_point<T>)
+    {
+        return (T)value;
+    }
+    else
+    {
+        return (T)std::clamp(std::lround(value), (long)std::numeric_limits<T>::min(), (long)std::numeric_limits<T>::max());
+    }
+}
+
+// Whether `_quantize<T>` gives `value` back unchanged.
+template <typename T>
+bool _quantizes_exactly(double value)
+{
+    if constexpr (std::floating_point<T>)
+    {
+        return true;
+    }
+    else
+    {
+        return value == std::round(value) && value >= std::numeric_limits<T>::min() && value <= std::numeric_limits<T>::max();
+    }
+}
+
 template <
-    gl_floating_point PositionDataType = GLfloat,
-    gl_floating_point TextureDataType = GLfloat
+    cube_data_type PositionDataType = GLfloat,
+    cube_data_type TextureDataType = GLfloat
 >
 struct Cube: _cube_origin_size<PositionDataType>, _cube_rotation<PositionDataType>, _cube_uv<TextureDataType>, _cube_material<TextureDataType>
 {
-    Cube(const Model::Cube& cube, const PoseTransform& cube_pose, const PoseTransform& model_pose, double zoom, const Model& model, int tex_width, int tex_height):
-        _cube_uv<TextureDataType>{
-            {(TextureDataType)((cube.uv.east[0] + model.tex_info.location[0]) / tex_width), (TextureDataType)((cube.uv.east[1] + model.tex_info.location[1]) / tex_height), (TextureDataType)(cube.uv.east[2] / tex_width), (TextureDataType)(cube.uv.east[3] / tex_height)},
-            {(TextureDataType)((cube.uv.south[0] + model.tex_info.location[0]) / tex_width), (TextureDataType)((cube.uv.south[1] + model.tex_info.location[1]) / tex_height), (TextureDataType)(cube.uv.south[2] / tex_width), (TextureDataType)(cube.uv.south[3] / tex_height)},
-            {(TextureDataType)((cube.uv.west[0] + model.tex_info.location[0]) / tex_width), (TextureDataType)((cube.uv.west[1] + model.tex_info.location[1]) / tex_height), (TextureDataType)(cube.uv.west[2] / tex_width), (TextureDataType)(cube.uv.west[3] / tex_height)},
-            {(TextureDataType)((cube.uv.north[0] + model.tex_info.location[0]) / tex_width), (TextureDataType)((cube.uv.north[1] + model.tex_info.location[1]) / tex_height), (TextureDataType)(cube.uv.north[2] / tex_width), (TextureDataType)(cube.uv.north[3] / tex_height)},
-            {(TextureDataType)((cube.uv.up[0] + model.tex_info.location[0]) / tex_width), (TextureDataType)((cube.uv.up[1] + model.tex_info.location[1]) / tex_height), (TextureDataType)(cube.uv.up[2] / tex_width), (TextureDataType)(cube.uv.up[3] / tex_height)},
-            {(TextureDataType)((cube.uv.down[0] + model.tex_info.location[0]) / tex_width), (TextureDataType)((cube.uv.down[1] + model.tex_info.location[1]) / tex_height), (TextureDataType)(cube.uv.down[2] / tex_width), (TextureDataType)(cube.uv.down[3] / tex_height)}
-        },
-        _cube_material<TextureDataType>{(TextureDataType)model.glow, (TextureDataType)model.metallic}
+    inline static constexpr bool packed_rotation = std::integral<PositionDataType>;
+    inline static constexpr bool packed_uv = std::integral<TextureDataType>;
+    // Full scale of a packed rotation component and of a packed material value.
+    inline static constexpr double rotation_scale = 32767.;
+    inline static constexpr double material_scale = 16.;
+
+    Cube(const Model::Cube& cube, const PoseTransform& cube_pose, const PoseTransform& model_pose, double zoom, const Model& model, int tex_width, int tex_height)
     {
         Quaternion origin(0, cube.origin[0], cube.origin[1], cube.origin[2]);
         origin = model_pose * (cube_pose * origin * zoom);
         Quaternion rotation = (model_pose * cube_pose).rotation;
-        new(static_cast<_cube_origin_size<PositionDataType>*>(this)) _cube_origin_size<PositionDataType>{
-            {(PositionDataType)origin.x, (PositionDataType)origin.y, (PositionDataType)origin.z},
-            {(PositionDataType)(cube.size[0] * zoom), (PositionDataType)(cube.size[1] * zoom), (PositionDataType)(cube.size[2] * zoom)}
+        const double origin_values[3]{origin.x, origin.y, origin.z};
+        for (int i = 0; i < 3; i++)
+        {
+            this->origin[i] = origin_values[i];
+            this->size[i] = cube.size[i] * zoom;
+        }
+        const double rotation_values[4]{rotation.x, rotation.y, rotation.z, rotation.w};
+        for (int i = 0; i < 4; i++)
+        {
+            this->rotation[i] = _quantize<PositionDataType>(packed_rotation? rotation_values[i] * rotation_scale: rotation_values[i]);
+        }
+        auto set_uv = [&](TextureDataType (&uv)[4], const double (&rect)[4])
+        {
+            const double texels[4]{rect[0] + model.tex_info.location[0], rect[1] + model.tex_info.location[1], rect[2], rect[3]};
+            for (int i = 0; i < 4; i++)
+            {
+                uv[i] = _quantize<TextureDataType>(packed_uv? texels[i]: texels[i] / (i % 2? tex_height: tex_width));
+            }
         };
-        new(static_cast<_cube_rotation<PositionDataType>*>(this)) _cube_rotation<PositionDataType>{
-            (PositionDataType)rotation.x, (PositionDataType)rotation.y, (PositionDataType)rotation.z, (PositionDataType)rotation.w
+        set_uv(this->east, cube.uv.east);
+        set_uv(this->south, cube.uv.south);
+        set_uv(this->west, cube.uv.west);
+        set_uv(this->north, cube.uv.north);
+        set_uv(this->up, cube.uv.up);
+        set_uv(this->down, cube.uv.down);
+        const double material_values[2]{model.glow, model.metallic};
+        for (int i = 0; i < 2; i++)
+        {
+            this->material[i] = _quantize<cube_material_t<TextureDataType>>(packed_uv? material_values[i] * material_scale: material_values[i]);
+        }
+    }
+    // Whether the UV rects of `cube` survive the packed format, which rounds them to whole atlas texels.
+    static bool packs_uv_exactly(const Model::Cube& cube, const Model& model)
+    {
+        for (const auto& rect: {cube.uv.east, cube.uv.south, cube.uv.west, cube.uv.north, cube.uv.up, cube.uv.down})
+        {
+            for (int i = 0; i < 4; i++)
+            {
+                if (!_quantizes_exactly<TextureDataType>(i < 2? rect[i] + model.tex_info.location[i]: rect[i]))
+                {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+    // Whether glow and metallic survive the packed format, 4.4 fixed point from 0 to 255/16.
+    static bool packs_material_exactly(const Model& model)
+    {
+        auto exact = [](double value)
+        {
+            return _quantizes_exactly<cube_material_t<TextureDataType>>(packed_uv? value * material_scale: value);
         };
+        return exact(model.glow) && exact(model.metallic);
+    }
+    // The cube's local axes in world space, the columns of rot_cube in shaders/vertex.glsl.
+    std::array<std::array<double, 3>, 3> axes() const
+    {
+        double q[4];
+        for (int i = 0; i < 4; i++)
+        {
+            q[i] = packed_rotation? this->rotation[i] / rotation_scale: this->rotation[i];
+        }
+        double norm = std::sqrt(q[0] * q[0] + q[1] * q[1] + q[2] * q[2] + q[3] * q[3]);
+        auto [x, y, z, w] = std::array<double, 4>{q[0] / norm, q[1] / norm, q[2] / norm, q[3] / norm};
+        return {{
+            {1 - 2 * (y * y + z * z), 2 * (x * y + z * w), 2 * (x * z - y * w)},
+            {2 * (x * y - z * w), 1 - 2 * (x * x + z * z), 2 * (y * z + x * w)},
+            {2 * (x * z + y * w), 2 * (y * z - x * w), 1 - 2 * (x * x + y * y)}
+        }};
     }
 };
 
-template <gl_floating_point P = GLfloat, gl_floating_point T = GLfloat>
+template <cube_data_type P = GLfloat, cube_data_type T = GLfloat>
 using CubeArray = std::vector<Cube<P, T>>;
 
 template <
-    gl_floating_point PositionDataType = GLfloat,
-    gl_floating_point TextureDataType = GLfloat
+    cube_data_type PositionDataType = GLfloat,
+    cube_data_type TextureDataType = GLfloat
 >
-    requires (sizeof(PositionDataType) == 4 && sizeof(TextureDataType) == 4)
+    requires (sizeof(TextureDataType) <= 4)
 struct TextureCube
 {
-    int cubes_per_row = 128;
-    std::vector<_cube_origin_size<PositionDataType>> origin_size;
-    std::vector<_cube_rotation<PositionDataType>> rotation;
-    std::vector<_cube_uv<TextureDataType>> uv;
-    std::vector<_cube_material<TextureDataType>> material;
+    using CubeType = Cube<PositionDataType, TextureDataType>;
+    // Every cube is `texels_per_cube` RGBA32UI texels, see shaders/raytrace/fragment.glsl. The intersection
+    // block comes first: three rows of the affine transform taking world space onto the cube's unit box.
+    // The shading block (uv east, south, west, north, up, down, then material) starts at `shading_texel`.
+    inline static constexpr size_t uv_words = sizeof(CubeType::east) / 4;
+    inline static constexpr size_t shading_texel = 3;
+    inline static constexpr size_t texels_per_cube = shading_texel + (6 * uv_words + (sizeof(CubeType::material) + 3) / 4 + 3) / 4;
+    // Flat cubes are given this thickness so that their transform stays invertible.
+    inline static constexpr double min_thickness = 1e-4;
 
-    TextureCube(const CubeArray<PositionDataType, TextureDataType>& cube_array)
+    std::vector<GLuint> records;
+
+    // Rows mapping a world point p to (row * vec4(p, 1)) in [0, 1]^3 inside the cube, the rotation and inverse size folded in.
+    static void world_to_cube(const CubeType& cube, GLfloat (&rows)[3][4])
+    {
+        auto axes = cube.axes();
+        for (int i = 0; i < 3; i++)
+        {
+            double scale = 1. / std::max((double)cube.size[i], min_thickness);
+            double offset = 0.;
+            for (int j = 0; j < 3; j++)
+            {
+                rows[i][j] = axes[i][j] * scale;
+                offset -= axes[i][j] * cube.origin[j];
+            }
+            rows[i][3] = offset * scale;
+        }
+    }
+
+    TextureCube() = default;
+    TextureCube(const CubeArray<PositionDataType, TextureDataType>& cube_array):
+        records(cube_array.size() * texels_per_cube * 4, 0)
     {
+        ProfileScope scope{"TextureCube::TextureCube", false, records.size() * sizeof(GLuint)};
+        GLuint* record = records.data();
+        auto put = [](GLuint* words, const auto& values)
+        {
+            std::memcpy(words, values, sizeof(values));
+        };
         for (const auto& cube: cube_array)
         {
-            origin_size.push_back(static_cast<_cube_origin_size<PositionDataType>>(cube));
-            rotation.push_back(static_cast<_cube_rotation<PositionDataType>>(cube));
-            uv.push_back(static_cast<_cube_uv<TextureDataType>>(cube));
-            material.push_back(static_cast<_cube_material<TextureDataType>>(cube));
+            GLfloat rows[3][4];
+            world_to_cube(cube, rows);
+            put(record, rows);
+            GLuint* shading = record + shading_texel * 4;
+            put(shading, cube.east);
+            put(shading + uv_words, cube.south);
+            put(shading + uv_words * 2, cube.west);
+            put(shading + uv_words * 3, cube.north);
+            put(shading + uv_words * 4, cube.up);
+            put(shading + uv_words * 5, cube.down);
+            put(shading + uv_words * 6, cube.material);
+            record += texels_per_cube * 4;
         }
     }
-    void buffer_to_texture(const Texture& origin_size_tex, const Texture& rotation_tex, const Texture& uv_tex, const Texture& material_tex) const
+    size_t size() const
+    {
+        return records.size() / (texels_per_cube * 4);
+    }
+    void buffer_to_texture(const Buffer& buffer, const Texture& texture) const
     {
-        int rows = std::ceil((double)origin_size.size() / cubes_per_row);
-        origin_size_tex.allocate(2 * cubes_per_row, rows, GL_RGB32F);
-        origin_size_tex.buffer(0, 0, 2 * cubes_per_row, rows, GL_RGB, (const PositionDataType*)origin_size.data());
-        rotation_tex.allocate(cubes_per_row, rows, GL_RGBA32F);
-        rotation_tex.buffer(0, 0, cubes_per_row, rows, GL_RGBA, (const PositionDataType*)rotation.data());
-        uv_tex.allocate(6 * cubes_per_row, rows, GL_RGBA32F);
-        uv_tex.buffer(0, 0, 6 * cubes_per_row, rows, GL_RGBA, (const TextureDataType*)uv.data());
-        material_tex.allocate(cubes_per_row, rows, GL_RG32F);
-        material_tex.buffer(0, 0, cubes_per_row, rows, GL_RG, (const TextureDataType*)material.data());
+        ProfileScope scope{"TextureCube::buffer_to_texture", true, records.size() * sizeof(GLuint)};
+        GLint max_texels;
+        glGetIntegerv(GL_MAX_TEXTURE_BUFFER_SIZE, &max_texels);
+        if (records.size() / 4 > (size_t)max_texels)
+        {
+            openglLogger.error("{} cubes exceed the texture buffer limit of {} texels.", size(), max_texels);
+            exit(-1);
+        }
+        buffer.allocate(records);
+        texture.attach(buffer, GL_RGBA32UI);
     }
 };
\ No newline at end of file
@@ -1,6 +1,7 @@
 #include "model.hpp"
 
 #include "../console/logger.hpp"
+#include "../opengl/profiler.hpp"
 
 #include <cmath>
 #include <fstream>
@@ -17,6 +18,8 @@ Model::Model(const fs::path& model_path, const fs::path& texture_path)
         modelLogger.error("Failed to open model file: {}.", model_path.string());
         exit(-1);
     }
+    std::error_code size_error;
+    ProfileScope scope{"Model::Model", false, fs::file_size(model_path, size_error)};
     Json::Value model_json;
     model_file >> model_json;
     model_file.close();
@@ -96,10 +99,13 @@ Model::Model(const fs::path& model_path, const fs::path& texture_path)
 bool Model::check_texture_size(const fs::path& texture_path, const Json::Value& geometry, const std::string& width_field, const std::string& height_field)
 {
     int texture_width, texture_height, n;
-    if (stbi_info(texture_path.c_str(), &texture_width, &texture_height, &n) == 0)
     {
-        modelLogger.error("Failed to read texture file {}: {}", texture_path.string(), stbi_failure_reason());
-        exit(-1);
+        ProfileScope scope{"stbi_info", false};
+        if (stbi_info(texture_path.c_str(), &texture_width, &texture_height, &n) == 0)
+        {
+            modelLogger.error("Failed to read texture file {}: {}", texture_path.string(), stbi_failure_reason());
+            exit(-1);
+        }
     }
     if (!geometry.isMember(width_field) || !geometry[width_field].isInt() ||
         !geometry.isMember(height_field) || !geometry[height_field].isInt())
@@ -1,6 +1,7 @@
 #include "scene.hpp"
 
 #include "../console/logger.hpp"
+#include "../opengl/profiler.hpp"
 
 #include <fstream>
 #include <json/json.h>
@@ -8,8 +9,6 @@
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb/stb_image.h>
 
-extern Logger modelLogger;
-
 const Json::Value& aquire_array(const Json::Value& json, const char* const name, int size, const fs::path& path)
 {
     if (!json.isMember(name) || !json[name].isArray() || (size != 0 && json[name].size() != size))
@@ -32,6 +31,7 @@ const Json::Value& aquire_double(const Json::Value& json, const char* const name
 
 Scene::Scene(const fs::path& scene_path)
 {
+    ProfileScope scope{"Scene::Scene", false};
     std::ifstream scene_file(scene_path);
     if (!scene_file)
     {
@@ -63,6 +63,28 @@ Scene::Scene(const fs::path& scene_path)
     {
         window_name = "RayTrace";
     }
+    if (scene_json.isMember("target_frame_time"))
+    {
+        target_frame_time = aquire_double(scene_json, "target_frame_time", scene_path).asDouble();
+    }
+    if (scene_json.isMember("min_render_scale"))
+    {
+        min_render_scale = aquire_double(scene_json, "min_render_scale", scene_path).asDouble();
+        if (min_render_scale <= 0 || min_render_scale > 1)
+        {
+            modelLogger.error("Scene file {} have an invalid `min_render_scale` field.", scene_path.string());
+            exit(-1);
+        }
+    }
+    if (scene_json.isMember("refine_frames"))
+    {
+        refine_frames = aquire_double(scene_json, "refine_frames", scene_path).asInt();
+        if (refine_frames < 0)
+        {
+            modelLogger.error("Scene file {} have an invalid `refine_frames` field.", scene_path.string());
+            exit(-1);
+        }
+    }
     if (!scene_json.isMember("camera") || !scene_json["camera"].isObject())
     {
         modelLogger.error("Scene file {} does not have a valid `camera` field.", scene_path.string());
@@ -155,8 +177,9 @@ Scene::Object::Object(
     this->model.metallic = metallic_json.asDouble();
 }
 
-void Scene::gen_altas(const Texture& altas)
+std::vector<GLubyte> Scene::pack_altas()
 {
+    ProfileScope scope{"Scene::pack_altas", false};
     int max_width = 0, max_height = 0;
     for (const auto& object: objects)
     {
@@ -177,7 +200,7 @@ void Scene::gen_altas(const Texture& altas)
     int rows = altas_max_width / max_width;
     altas_width = rows * max_width;
     altas_height = std::ceil((double)objects.size() / rows) * max_height;
-    altas.allocate(altas_width, altas_height, GL_RGBA8);
+    std::vector<GLubyte> pixels((size_t)altas_width * altas_height * 4, 0);
     int i = 0, j = 0;
     for (auto& object: objects)
     {
@@ -185,29 +208,27 @@ void Scene::gen_altas(const Texture& altas)
         object.model.tex_info.location[1] = j * max_height;
 
         int width, height, n;
-        unsigned char* tex = stbi_load(object.model.tex_info.path.c_str(), &width, &height, &n, 0);
-        if (tex == NULL)
+        unsigned char* tex;
         {
-            modelLogger.error("Failed to load texture {}: {}.", object.model.tex_info.path.string(), stbi_failure_reason());
-            exit(-1);
+            ProfileScope load_scope{"stbi_load", false};
+            tex = stbi_load(object.model.tex_info.path.c_str(), &width, &height, &n, 4);
+            if (tex == NULL)
+            {
+                modelLogger.error("Failed to load texture {}: {}.", object.model.tex_info.path.string(), stbi_failure_reason());
+                exit(-1);
+            }
+            load_scope.add_bytes((size_t)width * height * 4);
         }
 
-        GLenum format;
-        switch (n)
+        for (int row = 0; row < height; row++)
         {
-        case 4:
-            format = GL_RGBA;
-            break;
-        case 3:
-            format = GL_RGB;
-            break;
-        default:
-            modelLogger.error("Unsupported texture channel size in texture {}.", object.model.tex_info.path.string());
-            exit(-1);
+            std::copy_n(
+                tex + (size_t)row * width * 4,
+                width * 4,
+                pixels.begin() + (((size_t)j * max_height + row) * altas_width + i * max_width) * 4
+            );
         }
 
-        altas.buffer(i * max_width, j * max_height, width, height, format, tex);
-
         stbi_image_free(tex);
 
         i++;
@@ -217,4 +238,42 @@ void Scene::gen_altas(const Texture& altas)
             i = 0;
         }
     }
+    scope.add_bytes(pixels.size());
+    return pixels;
+}
+
+void Scene::gen_altas(const Texture& altas)
+{
+    ProfileScope scope{"Scene::gen_altas"};
+    std::vector<GLubyte> pixels = pack_altas();
+    scope.add_bytes(pixels.size());
+    altas.allocate(altas_width, altas_height, GL_RGBA8);
+    altas.buffer(0, 0, altas_width, altas_height, GL_RGBA, pixels.data());
+}
+
+static void push_clusters(std::vector<Scene::CubeCluster>& clusters, const std::unique_ptr<Model::Bone>& bone, size_t object, size_t& first)
+{
+    if (!bone->cubes.empty())
+    {
+        clusters.push_back({object, first, bone->cubes.size()});
+        first += bone->cubes.size();
+    }
+    for (const auto& child: bone->children)
+    {
+        push_clusters(clusters, child, object, first);
+    }
+}
+
+std::vector<Scene::CubeCluster> Scene::cube_clusters() const
+{
+    std::vector<CubeCluster> clusters;
+    size_t first = 0;
+    for (size_t object = 0; object < objects.size(); object++)
+    {
+        for (const auto& bone: objects[object].model.bones)
+        {
+            push_clusters(clusters, bone, object, first);
+        }
+    }
+    return clusters;
 }
\ No newline at end of file
@@ -3,8 +3,11 @@
 #include "cube.hpp"
 #include "model.hpp"
 #include "pose.hpp"
+#include "../console/logger.hpp"
 #include <memory>
 
+extern Logger modelLogger;
+
 class Scene
 {
 public:
@@ -17,11 +20,24 @@ public:
         Object(const Json::Value&, const Json::Value&, const Json::Value&, const fs::path&, const fs::path&, const Json::Value&, const Json::Value&);
     };
 
+    // Cubes of one bone, a contiguous range of `build_cube_array`.
+    struct CubeCluster
+    {
+        size_t object;
+        size_t first;
+        size_t count;
+    };
+
     int altas_max_width = 1024;
     int altas_width, altas_height;
 
     int window_size[2];
     std::string window_name;
+    // GPU milliseconds per frame the render resolution is adapted to, 0 keeps the full window resolution.
+    double target_frame_time = 0.;
+    double min_render_scale = 0.25;
+    // Frames a still view is refined for before the interactive loop idles, 0 refines forever.
+    int refine_frames = 256;
     struct
     {
         double position[3];
@@ -37,38 +53,65 @@ public:
     std::vector<Object> objects;
 
     Scene(const fs::path&);
+    // Lay every object texture out in one RGBA8 image, filling in `altas_width`/`altas_height` and each texture location.
+    std::vector<GLubyte> pack_altas();
     void gen_altas(const Texture&);
 
-    template <gl_floating_point P, gl_floating_point T>
-    void push_cubes(CubeArray<P, T>& cubes, const std::unique_ptr<Model::Bone>& bone, const PoseTransform& model_pose, const PoseTransform& bone_pose, double zoom, const Model& model) const
+    // One cluster per bone holding cubes, in the order `build_cube_array` lays them out.
+    std::vector<CubeCluster> cube_clusters() const;
+
+    template <cube_data_type P, cube_data_type T>
+    void push_cubes(CubeArray<P, T>& cubes, const std::unique_ptr<Model::Bone>& bone, const PoseTransform& model_pose, const PoseTransform& bone_pose, double zoom, const Model& model, size_t& inexact_uvs) const
     {
         PoseTransform poseBone = bone_pose * PoseTransform(bone->rotation, bone->pivot);
+        modelLogger.trace("Bone with {} cubes and {} children starts at cube {}.", bone->cubes.size(), bone->children.size(), cubes.size());
         for (const auto& cube: bone->cubes)
         {
             PoseTransform poseCube = poseBone * PoseTransform(cube->rotation, cube->pivot);
             cubes.emplace_back(*cube, poseCube, model_pose, zoom, model, altas_width, altas_height);
+            inexact_uvs += !Cube<P, T>::packs_uv_exactly(*cube, model);
         }
         for (const auto& child: bone->children)
         {
-            push_cubes(cubes, child, model_pose, poseBone, zoom, model);
+            push_cubes(cubes, child, model_pose, poseBone, zoom, model, inexact_uvs);
         }
     }
-    template <gl_floating_point P = GLfloat, gl_floating_point T = GLfloat>
+    // Append the cubes of `objects[index]` turned by `yaw` radians about the vertical axis through its position,
+    // returns how many of them have UVs the packed format rounds.
+    template <cube_data_type P = GLfloat, cube_data_type T = GLfloat>
+    size_t push_object(CubeArray<P, T>& cubes, size_t index, double yaw = 0.) const
+    {
+        const auto& object = objects[index];
+        PoseTransform pose(
+            Quaternion(std::cos(yaw / 2), 0, std::sin(yaw / 2), 0) * object.rotation,
+            Quaternion(0, object.position[0], object.position[1], object.position[2])
+        );
+        PoseTransform id_pose(Quaternion(1, 0, 0, 0), Quaternion(0, 0, 0, 0));
+        size_t inexact_uvs = 0;
+        for (const auto& bone: object.model.bones)
+        {
+            push_cubes<P, T>(cubes, bone, pose, id_pose, object.zoom, object.model, inexact_uvs);
+        }
+        return inexact_uvs;
+    }
+    template <cube_data_type P = GLfloat, cube_data_type T = GLfloat>
     CubeArray<P, T> build_cube_array() const
     {
+        ProfileScope scope{"Scene::build_cube_array", false};
         CubeArray<P, T> cubes;
-        PoseTransform id_pose(Quaternion(1, 0, 0, 0), Quaternion(0, 0, 0, 0));
-        for (const auto& object: objects)
+        for (size_t i = 0; i < objects.size(); i++)
         {
-            PoseTransform pose(
-                object.rotation,
-                Quaternion(0, object.position[0], object.position[1], object.position[2])
-            );
-            for (const auto& bone: object.model.bones)
+            size_t first = cubes.size();
+            if (size_t inexact_uvs = push_object(cubes, i))
+            {
+                modelLogger.info("Object {}: {} of {} cubes have UVs off whole texels, the packed format rounds them.", i, inexact_uvs, cubes.size() - first);
+            }
+            if (!Cube<P, T>::packs_material_exactly(objects[i].model))
             {
-                push_cubes<P, T>(cubes, bone, pose, id_pose, object.zoom, object.model);
+                modelLogger.info("Object {}: glow {} and metallic {} are not multiples of 1/16 in [0, 255/16], the packed format rounds and clamps them.", i, objects[i].model.glow, objects[i].model.metallic);
             }
         }
+        scope.add_bytes(cubes.size() * sizeof(Cube<P, T>));
         return cubes;
     }
 };
\ No newline at end of file
@@ -0,0 +1,33 @@
+#include "buffer.hpp"
+#include "state.hpp"
+
+Buffer::Buffer()
+{
+    glCreateBuffers(1, &id);
+}
+
+void Buffer::allocate(GLsizeiptr size, GLbitfield flags) const
+{
+    glNamedBufferStorage(id, size, nullptr, flags);
+}
+
+void Buffer::bind(GLenum target) const
+{
+    gl_state.bind_buffer(target, id);
+}
+
+void Buffer::unbind(GLenum target) const
+{
+    gl_state.bind_buffer(target, 0);
+}
+
+void Buffer::bind_base(GLenum target, GLuint index) const
+{
+    gl_state.bind_buffer_base(target, index, id);
+}
+
+Buffer::~Buffer()
+{
+    gl_state.forget_buffer(id);
+    glDeleteBuffers(1, &id);
+}
\ No newline at end of file
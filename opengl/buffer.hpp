@@ -0,0 +1,41 @@
+#pragma once
+
+#include "common.hpp"
+
+#include <vector>
+
+class Buffer
+{
+    GLuint id;
+    friend class Texture;
+public:
+    Buffer();
+
+    // https://registry.khronos.org/OpenGL-Refpages/gl4/html/glBufferStorage.xhtml
+    template <typename T>
+    void allocate(const std::vector<T>& data, GLbitfield flags = 0) const
+    {
+        glNamedBufferStorage(id, data.size() * sizeof(T), data.data(), flags);
+    }
+    void allocate(GLsizeiptr, GLbitfield = 0) const;
+
+    // https://registry.khronos.org/OpenGL-Refpages/gl4/html/glBufferSubData.xhtml
+    template <typename T>
+    void write(const T& data, GLintptr offset = 0) const
+    {
+        glNamedBufferSubData(id, offset, sizeof(T), &data);
+    }
+
+    // https://registry.khronos.org/OpenGL-Refpages/gl4/html/glGetBufferSubData.xhtml
+    template <typename T>
+    void read(T& data, GLintptr offset = 0) const
+    {
+        glGetNamedBufferSubData(id, offset, sizeof(T), &data);
+    }
+
+    void bind(GLenum) const;
+    void unbind(GLenum) const;
+    // https://registry.khronos.org/OpenGL-Refpages/gl4/html/glBindBufferBase.xhtml
+    void bind_base(GLenum, GLuint) const;
+    ~Buffer();
+};
\ No newline at end of file
@@ -0,0 +1,67 @@
+#include "framebuffer.hpp"
+
+Framebuffer::Framebuffer(GLsizei width, GLsizei height, std::initializer_list<GLenum> color_formats, GLenum depth_format):
+    width(width),
+    height(height),
+    color_attachments(color_formats.size())
+{
+    glCreateFramebuffers(1, &id);
+    std::vector<GLenum> draw_buffers;
+    GLenum attachment = GL_COLOR_ATTACHMENT0;
+    auto format = color_formats.begin();
+    for (const auto& texture: color_attachments)
+    {
+        texture.allocate(width, height, *format++);
+        glNamedFramebufferTexture(id, attachment, texture.id, 0);
+        draw_buffers.push_back(attachment++);
+    }
+    glNamedFramebufferDrawBuffers(id, draw_buffers.size(), draw_buffers.data());
+    if (depth_format)
+    {
+        depth_attachment.emplace();
+        depth_attachment->allocate(width, height, depth_format);
+        glNamedFramebufferTexture(id, GL_DEPTH_ATTACHMENT, depth_attachment->id, 0);
+    }
+    GLenum status = glCheckNamedFramebufferStatus(id, GL_FRAMEBUFFER);
+    if (status != GL_FRAMEBUFFER_COMPLETE)
+    {
+        openglLogger.error("Framebuffer of size {}x{} is incomplete: status {:#x}.", width, height, status);
+        exit(-1);
+    }
+}
+
+void Framebuffer::bind() const
+{
+    glBindFramebuffer(GL_FRAMEBUFFER, id);
+}
+
+void Framebuffer::unbind() const
+{
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+const Texture& Framebuffer::color(size_t index) const
+{
+    return color_attachments[index];
+}
+
+const Texture& Framebuffer::depth() const
+{
+    return depth_attachment.value();
+}
+
+void Framebuffer::blit(GLsizei src_width, GLsizei src_height, GLsizei dst_width, GLsizei dst_height, GLenum filter) const
+{
+    glNamedFramebufferReadBuffer(id, GL_COLOR_ATTACHMENT0);
+    glBlitNamedFramebuffer(
+        id, 0,
+        0, 0, std::min(src_width, width), std::min(src_height, height),
+        0, 0, dst_width, dst_height,
+        GL_COLOR_BUFFER_BIT, filter
+    );
+}
+
+Framebuffer::~Framebuffer()
+{
+    glDeleteFramebuffers(1, &id);
+}
\ No newline at end of file
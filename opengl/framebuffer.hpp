@@ -0,0 +1,38 @@
+#pragma once
+
+#include "texture.hpp"
+
+#include <initializer_list>
+#include <optional>
+#include <vector>
+
+class Framebuffer
+{
+    GLuint id;
+    const GLsizei width, height;
+    std::vector<Texture> color_attachments;
+    std::optional<Texture> depth_attachment;
+public:
+    // Every color attachment and the optional depth attachment share the same size.
+    Framebuffer(GLsizei, GLsizei, std::initializer_list<GLenum>, GLenum = 0);
+    void bind() const;
+    void unbind() const;
+    const Texture& color(size_t) const;
+    const Texture& depth() const;
+
+    // Copy the lower-left `src_width` x `src_height` corner of color attachment 0 onto the default framebuffer.
+    void blit(GLsizei src_width, GLsizei src_height, GLsizei dst_width, GLsizei dst_height, GLenum filter = GL_LINEAR) const;
+
+    // https://registry.khronos.org/OpenGL-Refpages/gl4/html/glReadPixels.xhtml
+    template <is_gl_type T>
+    void read(size_t attachment, GLint x, GLint y, GLsizei width, GLsizei height, GLenum format, T* data) const
+    {
+        glNamedFramebufferReadBuffer(id, GL_COLOR_ATTACHMENT0 + attachment);
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, id);
+        glPixelStorei(GL_PACK_ALIGNMENT, 1);
+        glReadPixels(x, y, width, height, format, gl_type_enum_v<T>, data);
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+    }
+
+    ~Framebuffer();
+};
\ No newline at end of file
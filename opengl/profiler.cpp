@@ -0,0 +1,201 @@
+#include "profiler.hpp"
+#include "state.hpp"
+
+#include <fstream>
+
+void Profiler::enable(const fs::path& prefix)
+{
+    epoch = Clock::now();
+    dump_prefix = prefix;
+    enabled.store(true, std::memory_order_relaxed);
+}
+
+void Profiler::enable_gpu()
+{
+    if (!is_enabled())
+    {
+        return;
+    }
+    glGenQueries(ring_size, queries);
+    // The GPU clock is lined up with the CPU one through a timestamp taken now.
+    glGetInteger64v(GL_TIMESTAMP, &gpu_epoch);
+    gpu_epoch -= (GLint64)(now() * 1e6);
+    gpu_enabled.store(true, std::memory_order_relaxed);
+}
+
+bool Profiler::is_enabled() const
+{
+    return enabled.load(std::memory_order_relaxed);
+}
+
+double Profiler::now() const
+{
+    return std::chrono::duration<double, std::milli>(Clock::now() - epoch).count();
+}
+
+bool Profiler::acquire_queries(size_t& first)
+{
+    if (!outstanding.empty() && issued + 2 - *outstanding.begin() > ring_size)
+    {
+        dropped++;
+        return false;
+    }
+    first = issued;
+    issued += 2;
+    outstanding.insert(first);
+    return true;
+}
+
+void Profiler::record(const Sample& sample)
+{
+    std::lock_guard lock(mutex);
+    if (samples.size() < max_samples)
+    {
+        samples.push_back(sample);
+    }
+    Stats& entry = stats[{sample.gpu, sample.name}];
+    entry.sum += sample.duration;
+    entry.max = std::max(entry.max, sample.duration);
+    entry.count++;
+}
+
+void Profiler::resolve(bool wait)
+{
+    size_t done = 0;
+    for (const auto& query: pending)
+    {
+        GLuint begin = queries[query.first % ring_size], end = queries[(query.first + 1) % ring_size];
+        GLint available;
+        glGetQueryObjectiv(end, GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available && !wait)
+        {
+            break;
+        }
+        GLuint64 begin_time, end_time;
+        glGetQueryObjectui64v(begin, GL_QUERY_RESULT, &begin_time);
+        glGetQueryObjectui64v(end, GL_QUERY_RESULT, &end_time);
+        record({query.name, query.frame, true, 0, (GLint64)(begin_time - gpu_epoch) / 1e6, (end_time - begin_time) / 1e6, 0});
+        outstanding.erase(query.first);
+        done++;
+    }
+    pending.erase(pending.begin(), pending.begin() + done);
+}
+
+void Profiler::report()
+{
+    uint64_t frame = frame_index.load(std::memory_order_relaxed);
+    uint64_t frames = std::max<uint64_t>(frame - reported_frame, 1);
+    reported_frame = frame;
+    std::lock_guard lock(mutex);
+    for (auto& [key, entry]: stats)
+    {
+        if (entry.count)
+        {
+            profiler_logger.info("{} {}: {:.3f} ms per frame, {:.3f} ms max over {} calls.", key.first? "GPU": "CPU", key.second, entry.sum / frames, entry.max, entry.count);
+        }
+        entry = {};
+    }
+    auto binds = gl_state.take_counts();
+    profiler_logger.info("GL binds: {} issued, {} elided.", binds.issued, binds.elided);
+    if (dropped)
+    {
+        profiler_logger.info("{} GPU scopes dropped, the query ring was full.", dropped);
+        dropped = 0;
+    }
+}
+
+void Profiler::frame()
+{
+    if (!is_enabled())
+    {
+        return;
+    }
+    if (gpu_enabled.load(std::memory_order_relaxed))
+    {
+        resolve(false);
+    }
+    if ((frame_index.fetch_add(1, std::memory_order_relaxed) + 1) % report_frames == 0)
+    {
+        report();
+    }
+}
+
+void Profiler::dump() const
+{
+    std::ofstream csv(fs::path(dump_prefix) += ".csv");
+    std::ofstream trace(fs::path(dump_prefix) += ".json");
+    if (!csv || !trace)
+    {
+        profiler_logger.error("Cannot write profile to {}.", dump_prefix.string());
+        return;
+    }
+    csv << "frame,device,thread,scope,start_ms,duration_ms,bytes\n";
+    // Chrome trace_event format, see chrome://tracing; GPU scopes get a process of their own.
+    trace << "{\"traceEvents\":[\n";
+    bool first = true;
+    for (const auto& sample: samples)
+    {
+        csv << std::format("{},{},{},{},{:.6f},{:.6f},{}\n", sample.frame, sample.gpu? "gpu": "cpu", sample.thread, sample.name, sample.start, sample.duration, sample.bytes);
+        trace << std::format(
+            "{}{{\"name\":\"{}\",\"cat\":\"{}\",\"ph\":\"X\",\"pid\":{},\"tid\":{},\"ts\":{:.3f},\"dur\":{:.3f},\"args\":{{\"frame\":{},\"bytes\":{}}}}}",
+            first? "": ",\n", sample.name, sample.gpu? "gpu": "cpu", sample.gpu? 2: 1, sample.thread, sample.start * 1e3, sample.duration * 1e3, sample.frame, sample.bytes
+        );
+        first = false;
+    }
+    trace << "\n]}\n";
+    profiler_logger.info("{} samples written to {}.csv and .json.", samples.size(), dump_prefix.string());
+}
+
+void Profiler::finish()
+{
+    if (!is_enabled())
+    {
+        return;
+    }
+    if (gpu_enabled.exchange(false, std::memory_order_relaxed))
+    {
+        resolve(true);
+        glDeleteQueries(ring_size, queries);
+    }
+    report();
+    dump();
+    enabled.store(false, std::memory_order_relaxed);
+}
+
+ProfileScope::ProfileScope(const char* name, bool gpu, size_t bytes):
+    name(name),
+    active(profiler.is_enabled()),
+    gpu(active && gpu && profiler.gpu_enabled.load(std::memory_order_relaxed) && profiler.acquire_queries(first_query)),
+    frame(profiler.frame_index.load(std::memory_order_relaxed)),
+    bytes(bytes)
+{
+    if (this->gpu)
+    {
+        glQueryCounter(profiler.queries[first_query % Profiler::ring_size], GL_TIMESTAMP);
+    }
+    if (active)
+    {
+        start = profiler.now();
+    }
+}
+
+void ProfileScope::add_bytes(size_t count)
+{
+    bytes += count;
+}
+
+ProfileScope::~ProfileScope()
+{
+    if (!active)
+    {
+        return;
+    }
+    double end = profiler.now();
+    if (gpu)
+    {
+        glQueryCounter(profiler.queries[(first_query + 1) % Profiler::ring_size], GL_TIMESTAMP);
+        profiler.pending.push_back({name, frame, first_query});
+    }
+    thread_local const size_t thread = ++profiler.thread_count;
+    profiler.record({name, frame, false, thread, start, end - start, bytes});
+}
\ No newline at end of file
@@ -0,0 +1,107 @@
+#pragma once
+
+#include "common.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string_view>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+// Named CPU and GPU scopes, collected per frame while enabled. CPU scopes need no GL context, so recording can
+// start before the window exists and cover loading; GPU scopes join once `enable_gpu` is called. They are
+// bracketed with timestamp queries from a ring that is only read back once the driver reports the results
+// available, so nothing stalls.
+class Profiler
+{
+    inline static const Logger profiler_logger{"Profiler"};
+    using Clock = std::chrono::steady_clock;
+    struct Sample
+    {
+        const char* name;
+        uint64_t frame;
+        bool gpu;
+        size_t thread;
+        double start, duration;
+        size_t bytes;
+    };
+    struct PendingQuery
+    {
+        const char* name;
+        uint64_t frame;
+        size_t first;
+    };
+    struct Stats
+    {
+        double sum = 0., max = 0.;
+        size_t count = 0;
+    };
+    inline static constexpr size_t ring_size = 512;
+    // Samples kept for the dump, later ones only reach the rolling stats.
+    inline static constexpr size_t max_samples = 1 << 20;
+    inline static constexpr uint64_t report_frames = 300;
+
+    // Read by scopes on any thread, hence atomic; everything else GPU-related stays on the GL thread.
+    std::atomic<bool> enabled = false, gpu_enabled = false;
+    Clock::time_point epoch;
+    // GPU timestamp taken at `epoch`, in nanoseconds.
+    GLint64 gpu_epoch = 0;
+    GLuint queries[ring_size];
+    size_t issued = 0;
+    // First query of every GPU scope not resolved yet, open ones included; the oldest bounds ring reuse.
+    std::set<size_t> outstanding;
+    std::vector<PendingQuery> pending;
+    std::atomic<uint64_t> frame_index = 0;
+    // Frame index of the last report, the stats since then average over the frames in between.
+    uint64_t reported_frame = 0;
+    uint64_t dropped = 0;
+    std::atomic<size_t> thread_count = 0;
+    std::mutex mutex;
+    std::vector<Sample> samples;
+    std::map<std::pair<bool, std::string_view>, Stats> stats;
+    fs::path dump_prefix;
+
+    double now() const;
+    bool acquire_queries(size_t&);
+    void record(const Sample&);
+    void resolve(bool wait);
+    void report();
+    void dump() const;
+    friend class ProfileScope;
+public:
+    // Start recording CPU scopes; `prefix`.csv and `prefix`.json are written by `finish`.
+    void enable(const fs::path& prefix);
+    // Record GPU scopes as well from now on, needs a current GL context.
+    void enable_gpu();
+    bool is_enabled() const;
+    // Call once per presented frame, it picks up finished queries and logs rolling stats and GL bind counts now and then.
+    void frame();
+    void finish();
+};
+
+inline Profiler profiler;
+
+// Times its own lifetime on the CPU and, if `gpu` is set, the GL commands issued meanwhile on the GPU, along
+// with the bytes it processed if given. GPU scopes may only be opened on the thread owning the GL context.
+class ProfileScope
+{
+    const char* const name;
+    const bool active;
+    // Set while `gpu` is initialized.
+    size_t first_query = 0;
+    const bool gpu;
+    const uint64_t frame;
+    double start = 0.;
+    size_t bytes;
+public:
+    ProfileScope(const char*, bool gpu = true, size_t bytes = 0);
+    ProfileScope(const ProfileScope&) = delete;
+    // For scopes that only learn their size on the way.
+    void add_bytes(size_t);
+    ~ProfileScope();
+};
\ No newline at end of file
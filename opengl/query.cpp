@@ -0,0 +1,52 @@
+#include "query.hpp"
+
+GpuTimer::GpuTimer()
+{
+    glGenQueries(ring_size, queries);
+}
+
+void GpuTimer::begin()
+{
+    if (issued - resolved == ring_size)
+    {
+        // Every query is still in flight, skip timing this frame rather than wait.
+        return;
+    }
+    glBeginQuery(GL_TIME_ELAPSED, queries[issued % ring_size]);
+    running = true;
+}
+
+void GpuTimer::end()
+{
+    if (running)
+    {
+        glEndQuery(GL_TIME_ELAPSED);
+        issued++;
+        running = false;
+    }
+}
+
+std::optional<double> GpuTimer::poll()
+{
+    std::optional<double> latest;
+    while (resolved < issued)
+    {
+        GLuint query = queries[resolved % ring_size];
+        GLint available;
+        glGetQueryObjectiv(query, GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available)
+        {
+            break;
+        }
+        GLuint64 elapsed;
+        glGetQueryObjectui64v(query, GL_QUERY_RESULT, &elapsed);
+        latest = elapsed / 1e6;
+        resolved++;
+    }
+    return latest;
+}
+
+GpuTimer::~GpuTimer()
+{
+    glDeleteQueries(ring_size, queries);
+}
\ No newline at end of file
@@ -0,0 +1,22 @@
+#pragma once
+
+#include "common.hpp"
+
+#include <optional>
+
+// Measures GPU time between `begin` and `end` without stalling: results are
+// read back a few frames later, once the driver reports them available.
+class GpuTimer
+{
+    inline static constexpr size_t ring_size = 4;
+    GLuint queries[ring_size];
+    size_t issued = 0, resolved = 0;
+    bool running = false;
+public:
+    GpuTimer();
+    void begin();
+    void end();
+    // Latest finished measurement in milliseconds, if any query completed since the last call.
+    std::optional<double> poll();
+    ~GpuTimer();
+};
\ No newline at end of file
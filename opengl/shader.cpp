@@ -1,6 +1,9 @@
 #include "shader.hpp"
+#include "profiler.hpp"
+#include "state.hpp"
 
 #include <fstream>
+#include <memory>
 
 class Shader
 {
@@ -55,11 +58,28 @@ public:
         return src_buffer;
     }
 
-    Shader(GLenum shader_type, const fs::path& source_path):
+    // Insert `#define`s after the `#version` line, which has to stay the first statement.
+    static std::string inject_defines(const std::string& source, const ShaderDefines& defines)
+    {
+        if (defines.empty())
+        {
+            return source;
+        }
+        size_t version = source.find("#version");
+        size_t line_end = version == std::string::npos? 0: source.find('\n', version) + 1;
+        std::string injected;
+        for (const auto& [name, value]: defines)
+        {
+            injected += std::format("#define {} {}\n", name, value);
+        }
+        return source.substr(0, line_end) + injected + source.substr(line_end);
+    }
+
+    Shader(GLenum shader_type, const std::string& shader_source, const fs::path& source_path):
         type(shader_type),
         id(glCreateShader(shader_type))
     {
-        std::string shader_source = get_file_source(source_path);
+        ProfileScope scope{"Shader::compile", false, shader_source.size()};
         const GLchar* src = shader_source.c_str();
         glShaderSource(id, 1, &src, NULL);
         glCompileShader(id);
@@ -83,43 +103,126 @@ public:
     }
 };
 
-Program::Program(const fs::path& vertex_source, const fs::path& fragment_source, GLenum drawMode):
+// FNV-1a, only used to name cache entries.
+static void hash_bytes(uint64_t& hash, std::string_view bytes)
+{
+    for (unsigned char c: bytes)
+    {
+        hash = (hash ^ c) * 0x100000001b3ull;
+    }
+}
+
+Program::Program(const fs::path& vertex_source, const fs::path& fragment_source, GLenum drawMode, const ShaderDefines& defines):
     id(glCreateProgram()),
     input(VertexInput(drawMode))
 {
-    Shader vertex = Shader(GL_VERTEX_SHADER, vertex_source);
-    Shader fragment = Shader(GL_FRAGMENT_SHADER, fragment_source);
-
-    glAttachShader(id, vertex.id);
-    glAttachShader(id, fragment.id);
-
-    link();
-
-    glDetachShader(id, vertex.id);
-    glDetachShader(id, fragment.id);
+    build({{GL_VERTEX_SHADER, vertex_source}, {GL_FRAGMENT_SHADER, fragment_source}}, defines);
 }
 
-Program::Program(const fs::path& vertex_source, const fs::path& geometry_source, const fs::path& fragment_source, GLenum drawMode):
+Program::Program(const fs::path& vertex_source, const fs::path& geometry_source, const fs::path& fragment_source, GLenum drawMode, const ShaderDefines& defines):
     id(glCreateProgram()),
     input(VertexInput(drawMode))
 {
-    Shader vertex = Shader(GL_VERTEX_SHADER, vertex_source);
-    Shader geometry = Shader(GL_GEOMETRY_SHADER, geometry_source);
-    Shader fragment = Shader(GL_FRAGMENT_SHADER, fragment_source);
+    build({{GL_VERTEX_SHADER, vertex_source}, {GL_GEOMETRY_SHADER, geometry_source}, {GL_FRAGMENT_SHADER, fragment_source}}, defines);
+}
+
+Program::Program(const fs::path& compute_source, const ShaderDefines& defines):
+    id(glCreateProgram()),
+    input(VertexInput(GL_POINTS))
+{
+    build({{GL_COMPUTE_SHADER, compute_source}}, defines);
+}
+
+void Program::build(const std::vector<std::pair<GLenum, fs::path>>& stages, const ShaderDefines& defines)
+{
+    ProfileScope scope{"Program::build", false};
+    std::vector<std::string> sources;
+    uint64_t hash = 0xcbf29ce484222325ull;
+    for (GLenum name: {GL_VENDOR, GL_RENDERER, GL_VERSION})
+    {
+        hash_bytes(hash, reinterpret_cast<const char*>(glGetString(name)));
+    }
+    for (const auto& [type, path]: stages)
+    {
+        const std::string& source = sources.emplace_back(Shader::inject_defines(Shader::get_file_source(path), defines));
+        hash_bytes(hash, std::string_view(reinterpret_cast<const char*>(&type), sizeof(type)));
+        hash_bytes(hash, source);
+    }
+    fs::path binary_path = binary_cache_path / std::format("{:016x}.bin", hash);
+
+    if (!load_binary(binary_path))
+    {
+        std::vector<std::unique_ptr<Shader>> shaders;
+        for (size_t i = 0; i < stages.size(); i++)
+        {
+            shaders.emplace_back(std::make_unique<Shader>(stages[i].first, sources[i], stages[i].second));
+            glAttachShader(id, shaders.back()->id);
+        }
+        glProgramParameteri(id, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+        if (!link())
+        {
+            exit(-1);
+        }
+        for (const auto& shader: shaders)
+        {
+            glDetachShader(id, shader->id);
+        }
+        save_binary(binary_path);
+    }
 
-    glAttachShader(id, vertex.id);
-    glAttachShader(id, geometry.id);
-    glAttachShader(id, fragment.id);
+    resolve_uniforms();
+}
 
-    link();
+bool Program::load_binary(const fs::path& binary_path) const
+{
+    std::ifstream file(binary_path, std::ios::binary);
+    GLenum format;
+    if (!file || !file.read(reinterpret_cast<char*>(&format), sizeof(format)))
+    {
+        return false;
+    }
+    std::vector<char> binary{std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+    ProfileScope scope{"Program::load_binary", false, binary.size()};
+    glProgramBinary(id, format, binary.data(), binary.size());
+    GLint status;
+    glGetProgramiv(id, GL_LINK_STATUS, &status);
+    if (status != GL_TRUE)
+    {
+        // The driver no longer accepts it, most likely after an update.
+        openglLogger.info("Stale program binary {}, recompiling.", binary_path.string());
+        return false;
+    }
+    return true;
+}
 
-    glDetachShader(id, vertex.id);
-    glDetachShader(id, geometry.id);
-    glDetachShader(id, fragment.id);
+void Program::save_binary(const fs::path& binary_path) const
+{
+    GLint formats, length;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+    glGetProgramiv(id, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (formats == 0 || length == 0)
+    {
+        return;
+    }
+    std::vector<char> binary(length);
+    GLenum format;
+    glGetProgramBinary(id, length, &length, &format, binary.data());
+
+    std::error_code error;
+    fs::create_directories(binary_path.parent_path(), error);
+    std::ofstream file(binary_path, std::ios::binary);
+    if (error || !file)
+    {
+        openglLogger.info("Cannot write program binary {}, it will be compiled again next time.", binary_path.string());
+        return;
+    }
+    file.write(reinterpret_cast<const char*>(&format), sizeof(format));
+    file.write(binary.data(), length);
 }
 
-void Program::link() const
+bool Program::link() const
 {
+    ProfileScope scope{"Program::link", false};
     glLinkProgram(id);
 
     GLint status;
@@ -131,43 +234,117 @@ void Program::link() const
         glGetProgramInfoLog(id, status, NULL, log_info);
         openglLogger.error("Program linkage error:\n{}", log_info);
         delete[] log_info;
+        return false;
+    }
+    return true;
+}
+
+void Program::resolve_uniforms()
+{
+    GLint uniform_count, max_length;
+    glGetProgramiv(id, GL_ACTIVE_UNIFORMS, &uniform_count);
+    glGetProgramiv(id, GL_ACTIVE_UNIFORM_MAX_LENGTH, &max_length);
+    std::string name(max_length, '\0');
+    for (GLint i = 0; i < uniform_count; i++)
+    {
+        GLsizei length;
+        GLint size;
+        GLenum type;
+        glGetActiveUniform(id, i, max_length, &length, &size, &type, name.data());
+        GLint location = glGetUniformLocation(id, name.c_str());
+        if (location == -1)
+        {
+            // Member of a uniform block.
+            continue;
+        }
+        std::string_view uniform(name.data(), length);
+        if (uniform.ends_with("[0]"))
+        {
+            uniform.remove_suffix(3);
+        }
+        uniformLocations.emplace(uniform, location);
+    }
+
+    GLuint frame_block = glGetUniformBlockIndex(id, "Frame");
+    if (frame_block != GL_INVALID_INDEX)
+    {
+        glUniformBlockBinding(id, frame_block, frame_block_binding);
+    }
+}
+
+GLint Program::location(const GLchar* name) const
+{
+    auto iter = uniformLocations.find(std::string_view(name));
+    if (iter == uniformLocations.end())
+    {
+        openglLogger.error("Cannot find uniform variable {} in shader.", name);
         exit(-1);
     }
+    return iter->second;
 }
 
 void Program::activate() const
 {
-    glUseProgram(id);
+    gl_state.use_program(id);
 }
 
 void Program::deactivate() const
 {
-    glUseProgram(0);
+    gl_state.use_program(0);
 }
 
-void Program::draw() const
+// Programs and textures are left bound, the next draw only rebinds what differs.
+void Program::bind_textures() const
 {
     for (auto const& [_, texture]: boundTextures)
     {
-        glActiveTexture(GL_TEXTURE0 + texture.second);
-        texture.first->bind();
+        texture.first->bind(texture.second);
     }
+}
+
+void Program::draw(const DrawList* list) const
+{
+    ProfileScope scope{"Program::draw"};
+    bind_textures();
     activate();
-    input.draw();
-    deactivate();
-    for (auto const& [_, texture]: boundTextures)
-    {
-        glActiveTexture(GL_TEXTURE0 + texture.second);
-        texture.first->unbind();
-    }
-    glActiveTexture(GL_TEXTURE0);
+    input.draw(list);
+}
+
+void Program::dispatch(GLuint groups_x, GLuint groups_y, GLuint groups_z) const
+{
+    bind_textures();
+    activate();
+    glDispatchCompute(groups_x, groups_y, groups_z);
+}
+
+void Program::dispatch_indirect(const Buffer& arguments, GLintptr offset) const
+{
+    bind_textures();
+    activate();
+    arguments.bind(GL_DISPATCH_INDIRECT_BUFFER);
+    glDispatchComputeIndirect(offset);
 }
 
 Program::~Program()
 {
+    gl_state.forget_program(id);
     glDeleteProgram(id);
 }
 
+ProgramVariants::ProgramVariants(std::function<std::unique_ptr<Program>(const ShaderDefines&)>&& factory):
+    factory(std::move(factory))
+{}
+
+Program& ProgramVariants::get(const ShaderDefines& defines)
+{
+    auto iter = programs.find(defines);
+    if (iter == programs.end())
+    {
+        iter = programs.emplace(defines, factory(defines)).first;
+    }
+    return *iter->second;
+}
+
 #define PARENS ()
 
 #define GLf GLfloat
@@ -191,15 +368,7 @@ Program::~Program()
 template <> \
 void Program::set(const GLchar* name, GEN_PARAM(type, n, __VA_ARGS__)) \
 { \
-    activate(); \
-    GLint location = glGetUniformLocation(id, name); \
-    if (location == -1) \
-    { \
-        openglLogger.error("Cannot find uniform variable {} in shader.", name); \
-        exit(-1); \
-    } \
-    glUniform ## n ## type (location, GEN_ARGS(n, __VA_ARGS__)); \
-    deactivate(); \
+    glProgramUniform ## n ## type (id, location(name), GEN_ARGS(n, __VA_ARGS__)); \
 }
 
 #define GEN_UNIFORM_SETTER_TYPE(type, ...) GEN_UNIFORM_SETTER_TYPE_I(type, __VA_ARGS__)
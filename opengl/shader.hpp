@@ -4,6 +4,10 @@
 #include "texture.hpp"
 #include "vertex.hpp"
 
+#include <array>
+#include <functional>
+#include <memory>
+
 template <typename... Ts>
 struct _are_all_the_same
 {
@@ -22,15 +26,32 @@ concept are_all_the_same = _are_all_the_same<Ts...>::value;
 template <typename T>
 concept gl_uniform_type = is_one_of<T, GLint, GLuint, GLfloat, GLdouble>;
 
+// Macros defined right after `#version` in every stage of a program, name to replacement.
+using ShaderDefines = std::map<std::string, std::string>;
+
 class Program
 {
     const GLuint id;
-    std::map<const std::string, std::pair<const Texture*, GLuint>> boundTextures{};
+    std::map<std::string, std::pair<const Texture*, GLuint>, std::less<>> boundTextures{};
+    // Locations of the active uniforms, resolved once after linking.
+    std::map<std::string, GLint, std::less<>> uniformLocations{};
     VertexInput input;
-    void link() const;
+    void build(const std::vector<std::pair<GLenum, fs::path>>&, const ShaderDefines&);
+    bool load_binary(const fs::path&) const;
+    void save_binary(const fs::path&) const;
+    bool link() const;
+    void resolve_uniforms();
+    GLint location(const GLchar*) const;
+    void bind_textures() const;
 public:
-    Program(const fs::path&, const fs::path&, GLenum);
-    Program(const fs::path&, const fs::path&, const fs::path&, GLenum);
+    // Binding point every program links its `Frame` uniform block to, see shaders/camera.glsl.
+    inline static const GLuint frame_block_binding = 0;
+    // Linked programs are kept here, keyed by their expanded sources and the driver, and reused on the next start.
+    inline static fs::path binary_cache_path = "../.cache/shaders";
+    Program(const fs::path&, const fs::path&, GLenum, const ShaderDefines& = {});
+    Program(const fs::path&, const fs::path&, const fs::path&, GLenum, const ShaderDefines& = {});
+    // Compute program, run with `dispatch` instead of `draw`.
+    explicit Program(const fs::path&, const ShaderDefines& = {});
     void activate() const;
     void deactivate() const;
     template <gl_uniform_type... Args>
@@ -56,8 +77,9 @@ public:
         input.setVertices(vertices);
         input.setIndices(std::vector<GLubyte>{0, 1, 2, 2, 3, 0});
     }
-    template <gl_floating_point P = GLfloat, gl_floating_point T = GLfloat>
-    void set_input(const CubeArray<P, T>& cubes)
+    // Streamed cubes can later be changed every frame through `update_input`.
+    template <cube_data_type P = GLfloat, cube_data_type T = GLfloat>
+    void set_input(const CubeArray<P, T>& cubes, bool streaming = false)
     {
         input.loadMemoryModel<Cube<P, T>>(
             &Cube<P, T>::origin,
@@ -70,8 +92,95 @@ public:
             &Cube<P, T>::up,
             &Cube<P, T>::down
         );
-        input.setVertices(cubes);
+        if (streaming)
+        {
+            input.setStreamingVertices(cubes);
+        }
+        else
+        {
+            input.setVertices(cubes);
+        }
+        set("packed_rotation", (GLint)Cube<P, T>::packed_rotation);
+        set("packed_uv", (GLint)Cube<P, T>::packed_uv);
     };
-    void draw() const;
+    // Instanced alternative to `set_input(cubes)`: a shared unit cube mesh drawn once per cube with the cube
+    // attributes advancing per instance, see shaders/instanced/vertex.glsl.
+    template <cube_data_type P = GLfloat, cube_data_type T = GLfloat>
+    void set_instanced_input(const CubeArray<P, T>& cubes)
+    {
+        struct Vertex
+        {
+            GLfloat corner[3];
+            GLfloat face_coord[2];
+            GLfloat face;
+        };
+        // Corner of the unit cube at (a, b) on each face, faces ordered east, south, west, north, up, down
+        // and oriented as in shaders/geometry.glsl.
+        auto corner = [](int face, GLfloat a, GLfloat b) -> std::array<GLfloat, 3>
+        {
+            switch (face)
+            {
+                case 0: return {1, 1 - b, 1 - a};
+                case 1: return {a, 1 - b, 1};
+                case 2: return {0, 1 - b, a};
+                case 3: return {1 - a, 1 - b, 0};
+                case 4: return {1 - a, 1, 1 - b};
+                default: return {1 - a, 0, b};
+            }
+        };
+        std::vector<Vertex> vertices;
+        std::vector<GLubyte> indices;
+        for (int face = 0; face < 6; face++)
+        {
+            GLubyte base = vertices.size();
+            for (auto [a, b]: {std::pair{0.f, 0.f}, {1.f, 0.f}, {1.f, 1.f}, {0.f, 1.f}})
+            {
+                auto [x, y, z] = corner(face, a, b);
+                vertices.push_back({{x, y, z}, {a, b}, (GLfloat)face});
+            }
+            for (GLubyte index: {0, 1, 2, 2, 3, 0})
+            {
+                indices.push_back(base + index);
+            }
+        }
+        input.loadMemoryModel<Vertex>(&Vertex::corner, &Vertex::face_coord, &Vertex::face);
+        input.setVertices(vertices);
+        input.setIndices(indices);
+        input.loadInstanceModel<Cube<P, T>>(
+            &Cube<P, T>::origin,
+            &Cube<P, T>::size,
+            &Cube<P, T>::rotation,
+            &Cube<P, T>::east,
+            &Cube<P, T>::south,
+            &Cube<P, T>::west,
+            &Cube<P, T>::north,
+            &Cube<P, T>::up,
+            &Cube<P, T>::down
+        );
+        input.setInstances(cubes);
+        set("packed_rotation", (GLint)Cube<P, T>::packed_rotation);
+        set("packed_uv", (GLint)Cube<P, T>::packed_uv);
+    }
+    // Replace the streamed cubes from `first` on with a contiguous range of the cube type given to `set_input`.
+    template <std::ranges::contiguous_range R>
+    void update_input(size_t first, const R& cubes)
+    {
+        input.updateVertices(first, cubes);
+    }
+    void draw(const DrawList* = nullptr) const;
+    // https://registry.khronos.org/OpenGL-Refpages/gl4/html/glDispatchCompute.xhtml
+    void dispatch(GLuint, GLuint = 1, GLuint = 1) const;
+    // https://registry.khronos.org/OpenGL-Refpages/gl4/html/glDispatchComputeIndirect.xhtml
+    void dispatch_indirect(const Buffer&, GLintptr = 0) const;
     ~Program();
+};
+
+// One program per define set, built and set up by `factory` the first time it is asked for.
+class ProgramVariants
+{
+    const std::function<std::unique_ptr<Program>(const ShaderDefines&)> factory;
+    std::map<ShaderDefines, std::unique_ptr<Program>> programs{};
+public:
+    ProgramVariants(std::function<std::unique_ptr<Program>(const ShaderDefines&)>&&);
+    Program& get(const ShaderDefines&);
 };
\ No newline at end of file
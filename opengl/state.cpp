@@ -0,0 +1,114 @@
+#include "state.hpp"
+
+bool GLState::update(GLuint& cached, GLuint value)
+{
+    if (cached == value)
+    {
+        elided++;
+        return false;
+    }
+    cached = value;
+    issued++;
+    return true;
+}
+
+void GLState::use_program(GLuint id)
+{
+    if (update(program, id))
+    {
+        glUseProgram(id);
+    }
+}
+
+void GLState::bind_vertex_array(GLuint id)
+{
+    if (update(vertex_array, id))
+    {
+        glBindVertexArray(id);
+    }
+}
+
+void GLState::bind_texture_unit(GLuint unit, GLuint id)
+{
+    if (unit >= texture_units.size())
+    {
+        texture_units.resize(unit + 1, unknown);
+    }
+    if (update(texture_units[unit], id))
+    {
+        glBindTextureUnit(unit, id);
+    }
+}
+
+void GLState::bind_buffer(GLenum target, GLuint id)
+{
+    auto [iter, _] = buffers.try_emplace(target, unknown);
+    if (update(iter->second, id))
+    {
+        glBindBuffer(target, id);
+    }
+}
+
+void GLState::bind_buffer_base(GLenum target, GLuint index, GLuint id)
+{
+    auto [iter, _] = indexed_buffers.try_emplace({target, index}, unknown);
+    if (update(iter->second, id))
+    {
+        glBindBufferBase(target, index, id);
+        // The generic binding point follows.
+        buffers[target] = id;
+    }
+}
+
+void GLState::forget_program(GLuint id)
+{
+    // A program deleted while in use stays current, its name is only released once another one is used.
+    if (program == id)
+    {
+        program = unknown;
+    }
+}
+
+void GLState::forget_vertex_array(GLuint id)
+{
+    if (vertex_array == id)
+    {
+        vertex_array = 0;
+    }
+}
+
+void GLState::forget_texture(GLuint id)
+{
+    for (GLuint& unit: texture_units)
+    {
+        if (unit == id)
+        {
+            unit = 0;
+        }
+    }
+}
+
+void GLState::forget_buffer(GLuint id)
+{
+    for (auto& [_, buffer]: buffers)
+    {
+        if (buffer == id)
+        {
+            buffer = 0;
+        }
+    }
+    for (auto& [_, buffer]: indexed_buffers)
+    {
+        if (buffer == id)
+        {
+            buffer = 0;
+        }
+    }
+}
+
+GLState::Counts GLState::take_counts()
+{
+    Counts counts{issued, elided};
+    issued = elided = 0;
+    return counts;
+}
\ No newline at end of file
@@ -0,0 +1,46 @@
+#pragma once
+
+#include "common.hpp"
+
+#include <cstdint>
+#include <map>
+#include <vector>
+
+// The bindings last made through it, so binding what is already bound costs no driver call. Binds of these
+// kinds must all go through it; objects are forgotten when deleted, since GL resets their bindings and may hand
+// the names out again.
+class GLState
+{
+    inline static constexpr GLuint unknown = ~0u;
+    GLuint program = unknown;
+    GLuint vertex_array = unknown;
+    std::vector<GLuint> texture_units;
+    std::map<GLenum, GLuint> buffers;
+    std::map<std::pair<GLenum, GLuint>, GLuint> indexed_buffers;
+    uint64_t issued = 0, elided = 0;
+    // Record `value` in `cached`, true when the call has to be made.
+    bool update(GLuint& cached, GLuint value);
+public:
+    struct Counts
+    {
+        uint64_t issued, elided;
+    };
+    // https://registry.khronos.org/OpenGL-Refpages/gl4/html/glUseProgram.xhtml
+    void use_program(GLuint);
+    // https://registry.khronos.org/OpenGL-Refpages/gl4/html/glBindVertexArray.xhtml
+    void bind_vertex_array(GLuint);
+    // https://registry.khronos.org/OpenGL-Refpages/gl4/html/glBindTextureUnit.xhtml
+    void bind_texture_unit(GLuint, GLuint);
+    // https://registry.khronos.org/OpenGL-Refpages/gl4/html/glBindBuffer.xhtml
+    void bind_buffer(GLenum, GLuint);
+    // https://registry.khronos.org/OpenGL-Refpages/gl4/html/glBindBufferBase.xhtml
+    void bind_buffer_base(GLenum, GLuint, GLuint);
+    void forget_program(GLuint);
+    void forget_vertex_array(GLuint);
+    void forget_texture(GLuint);
+    void forget_buffer(GLuint);
+    // Binds issued and elided since the last call.
+    Counts take_counts();
+};
+
+inline GLState gl_state;
\ No newline at end of file
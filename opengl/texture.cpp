@@ -1,44 +1,51 @@
 #include "texture.hpp"
 
 #include "shader.hpp"
+#include "state.hpp"
 
-Texture::Texture()
+Texture::Texture(GLenum target):
+    target(target)
 {
-    glGenTextures(1, &id);
-    bind();
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-    unbind();
+    glCreateTextures(target, 1, &id);
+    if (target != GL_TEXTURE_BUFFER)
+    {
+        glTextureParameteri(id, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTextureParameteri(id, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    }
 }
 
-void Texture::bind() const
+void Texture::bind(GLuint unit) const
 {
-    glBindTexture(GL_TEXTURE_2D, id);
+    gl_state.bind_texture_unit(unit, id);
 }
 
-void Texture::unbind() const
+void Texture::allocate(GLsizei width, GLsizei height, GLenum format) const
 {
-    glBindTexture(GL_TEXTURE_2D, 0);
+    glTextureStorage2D(id, 1, format, width, height);
 }
 
-void Texture::allocate(GLsizei width, GLsizei height, GLenum format) const
+void Texture::bind_image(GLuint unit, GLenum access, GLenum format) const
 {
-    bind();
-    glTextureStorage2D(id, 1, format, width, height);
-    unbind();
+    glBindImageTexture(unit, id, 0, GL_FALSE, 0, access, format);
+}
+
+void Texture::attach(const Buffer& buffer, GLenum format) const
+{
+    glTextureBuffer(id, format, buffer.id);
 }
 
 Texture::~Texture()
 {
+    gl_state.forget_texture(id);
     glDeleteTextures(1, &id);
 }
 
 template <>
 void Program::set(const GLchar* name, const Texture& texture)
 {
-    if (boundTextures.contains(name))
+    if (auto iter = boundTextures.find(std::string_view(name)); iter != boundTextures.end())
     {
-        boundTextures[name].first = &texture;
+        iter->second.first = &texture;
         return;
     }
     int index = boundTextures.size() + 1;
@@ -1,14 +1,16 @@
 #pragma once
 
-#include "common.hpp"
+#include "buffer.hpp"
 
 class Texture
 {
     GLuint id;
+    const GLenum target;
+    friend class Framebuffer;
 public:
-    Texture();
-    void bind() const;
-    void unbind() const;
+    Texture(GLenum = GL_TEXTURE_2D);
+    // https://registry.khronos.org/OpenGL-Refpages/gl4/html/glBindTextureUnit.xhtml
+    void bind(GLuint) const;
 
     // https://registry.khronos.org/OpenGL-Refpages/gl4/html/glTexStorage2D.xhtml
     void allocate(GLsizei, GLsizei, GLenum) const;
@@ -21,5 +23,18 @@ public:
         glTextureSubImage2D(id, 0, x, y, width, height, format, gl_type_enum_v<T>, data);
     }
 
+    // https://registry.khronos.org/OpenGL-Refpages/gl4/html/glClearTexImage.xhtml
+    template <is_gl_type T>
+    void clear(GLenum format, const T* data) const
+    {
+        glClearTexImage(id, 0, format, gl_type_enum_v<T>, data);
+    }
+
+    // https://registry.khronos.org/OpenGL-Refpages/gl4/html/glBindImageTexture.xhtml
+    void bind_image(GLuint, GLenum, GLenum) const;
+
+    // https://registry.khronos.org/OpenGL-Refpages/gl4/html/glTexBuffer.xhtml
+    void attach(const Buffer&, GLenum) const;
+
     ~Texture();
 };
\ No newline at end of file
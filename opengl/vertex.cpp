@@ -1,47 +1,100 @@
 #include "vertex.hpp"
+#include "profiler.hpp"
+#include "state.hpp"
 
 VertexInput::VertexInput(GLenum mode):
     drawMode(mode)
 {
-    glGenVertexArrays(1, &VAO);
-    glGenBuffers(1, &VBO);
-    glGenBuffers(1, &EBO);
+    glCreateVertexArrays(1, &VAO);
+    glCreateBuffers(1, &VBO);
+    glCreateBuffers(1, &EBO);
+    glCreateBuffers(1, &instanceVBO);
+    glVertexArrayElementBuffer(VAO, EBO);
 }
 
-void VertexInput::bindVBO() const
+GLint VertexInput::acquireRegion() const
 {
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-}
-
-void VertexInput::unbindVBO() const
-{
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    ProfileScope scope{"VertexInput::acquireRegion"};
+    region = (region + 1) % streamRegions;
+    if (fences[region])
+    {
+        while (glClientWaitSync(fences[region], GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000) == GL_TIMEOUT_EXPIRED)
+        {
+            openglLogger.info("Still waiting for the GPU to release streaming region {}.", region);
+        }
+        glDeleteSync(fences[region]);
+        fences[region] = nullptr;
+    }
+    auto& [first, last] = dirty[region];
+    if (first != last)
+    {
+        std::memcpy(mapped + region * shadow.size() + first, shadow.data() + first, last - first);
+        first = last = 0;
+    }
+    return region * vertexCount;
 }
 
-void VertexInput::bindEBO() const
+void VertexInput::releaseRegion() const
 {
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+    fences[region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
 }
 
-void VertexInput::unbindEBO() const
+void VertexInput::drawList(const DrawList& list, GLint base) const
 {
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    if (instanceCount)
+    {
+        // https://registry.khronos.org/OpenGL-Refpages/gl4/html/glMultiDrawElementsIndirect.xhtml
+        commands.clear();
+        for (size_t i = 0; i < list.first.size(); i++)
+        {
+            commands.push_back({(GLuint)indexCount, (GLuint)list.count[i], 0, 0, (GLuint)list.first[i]});
+        }
+        if (indirectBuffer == 0)
+        {
+            glCreateBuffers(1, &indirectBuffer);
+        }
+        glNamedBufferData(indirectBuffer, commands.size() * sizeof(DrawElementsIndirectCommand), commands.data(), GL_STREAM_DRAW);
+        gl_state.bind_buffer(GL_DRAW_INDIRECT_BUFFER, indirectBuffer);
+        glMultiDrawElementsIndirect(drawMode, indexType, nullptr, commands.size(), 0);
+    }
+    else
+    {
+        shiftedFirst.resize(list.first.size());
+        for (size_t i = 0; i < list.first.size(); i++)
+        {
+            shiftedFirst[i] = list.first[i] + base;
+        }
+        glMultiDrawArrays(drawMode, shiftedFirst.data(), list.count.data(), list.first.size());
+    }
 }
 
-void VertexInput::draw() const
+void VertexInput::draw(const DrawList* list) const
 {
     if (vertexCount)
     {
-        bind();
-        if (indexCount)
+        GLint base = mapped? acquireRegion(): 0;
+        openglLogger.trace("Drawing {} vertices, {} instances, {} ranges from vertex {}.", vertexCount, instanceCount, list? list->first.size(): 0, base);
+        gl_state.bind_vertex_array(VAO);
+        if (list)
+        {
+            drawList(*list, base);
+        }
+        else if (instanceCount)
+        {
+            glDrawElementsInstanced(drawMode, indexCount, indexType, 0, instanceCount);
+        }
+        else if (indexCount)
         {
-            glDrawElements(drawMode, indexCount, indexType, 0);
+            glDrawElementsBaseVertex(drawMode, indexCount, indexType, 0, base);
         }
         else
         {
-            glDrawArrays(drawMode, 0, vertexCount);
+            glDrawArrays(drawMode, base, vertexCount);
+        }
+        if (mapped)
+        {
+            releaseRegion();
         }
-        unbind();
     }
     else
     {
@@ -49,19 +102,27 @@ void VertexInput::draw() const
     }
 }
 
-void VertexInput::bind() const
-{
-    glBindVertexArray(VAO);
-}
-
-void VertexInput::unbind() const
-{
-    glBindVertexArray(0);
-}
-
 VertexInput::~VertexInput()
 {
+    for (GLsync fence: fences)
+    {
+        if (fence)
+        {
+            glDeleteSync(fence);
+        }
+    }
+    if (mapped)
+    {
+        glUnmapNamedBuffer(VBO);
+    }
+    gl_state.forget_vertex_array(VAO);
     glDeleteVertexArrays(1, &VAO);
-    glDeleteBuffers(1, &VBO);
-    glDeleteBuffers(1, &EBO);
+    for (GLuint buffer: {VBO, EBO, instanceVBO, indirectBuffer})
+    {
+        if (buffer)
+        {
+            gl_state.forget_buffer(buffer);
+            glDeleteBuffers(1, &buffer);
+        }
+    }
 }
\ No newline at end of file
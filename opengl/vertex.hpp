@@ -1,9 +1,20 @@
 #pragma once
 
-#include "common.hpp"
+#include "profiler.hpp"
 
+#include <cstdint>
+#include <cstring>
+#include <ranges>
+#include <span>
 #include <vector>
 
+// Ranges of vertices of a non-indexed input, or of instances of an instanced one, to draw instead of all of them.
+struct DrawList
+{
+    std::vector<GLint> first;
+    std::vector<GLsizei> count;
+};
+
 class VertexInput
 {
     template <typename T>
@@ -20,26 +31,125 @@ class VertexInput
         inline static const size_t Size = N;
     };
 
-    GLuint VAO, VBO, EBO;
-    size_t indexCount = 0, vertexCount = 0;
+    GLuint VAO, VBO, EBO, instanceVBO;
+    size_t indexCount = 0, vertexCount = 0, instanceCount = 0;
+    GLuint vertexAttributes = 0;
+    // Scratch space for `draw(const DrawList*)`: offset firsts, and indirect commands of instanced draws.
+    mutable GLuint indirectBuffer = 0;
+    mutable std::vector<GLint> shiftedFirst{};
+    struct DrawElementsIndirectCommand
+    {
+        GLuint count;
+        GLuint instanceCount;
+        GLuint firstIndex;
+        GLint baseVertex;
+        GLuint baseInstance;
+    };
+    mutable std::vector<DrawElementsIndirectCommand> commands{};
+    void drawList(const DrawList&, GLint) const;
     GLenum indexType = 0;
     const GLenum drawMode;
-    void bindVBO() const;
-    void unbindVBO() const;
-    void bindEBO() const;
-    void unbindEBO() const;
+    // Streaming mode keeps `streamRegions` copies of the vertices in one persistently mapped VBO and draws
+    // them in turn, each fenced until the GPU is done with it. `shadow` holds the latest data, `dirty` the
+    // byte range of it every region still has to pick up before it is drawn again. Instanced inputs do not stream.
+    inline static const size_t streamRegions = 3;
+    GLubyte* mapped = nullptr;
+    std::vector<GLubyte> shadow{};
+    mutable size_t region = 0;
+    mutable GLsync fences[streamRegions]{};
+    mutable std::pair<size_t, size_t> dirty[streamRegions]{};
+    GLint acquireRegion() const;
+    // Vertex buffer binding indices of the VAO: per-vertex data from VBO, per-instance data from instanceVBO.
+    inline static const GLuint vertexBinding = 0;
+    inline static const GLuint instanceBinding = 1;
+    // Point consecutive locations from `first` at the members of `T` in vertex buffer binding `binding`, returns the next free location.
+    template <typename T, typename... U, typename... Members>
+    static GLuint loadAttributes(GLuint vao, GLuint first, GLuint binding, Members (U::* const... members))
+    {
+        GLuint index = first;
+        (
+            (
+                glVertexArrayAttribFormat(
+                    vao,
+                    index,
+                    GetArraySize<Members>::Size,
+                    gl_type_enum_v<typename GetArraySize<Members>::Type>,
+                    GL_FALSE,
+                    (GLuint)reinterpret_cast<uintptr_t>(
+                        &(static_cast<T*>(nullptr)->*static_cast<Members T::*>(members))
+                    )
+                ),
+                glVertexArrayAttribBinding(vao, index, binding),
+                glEnableVertexArrayAttrib(vao, index++)
+            ), ...
+        );
+        return index;
+    }
+    void releaseRegion() const;
 public:
     VertexInput(GLenum);
     template <typename T>
     void setVertices(const std::vector<T>& data, GLenum usage = GL_STATIC_DRAW)
     {
+        if (mapped)
+        {
+            openglLogger.error("Streaming VBO can not be respecified.");
+            exit(-1);
+        }
+        vertexCount = data.size();
+
+        ProfileScope scope{"VertexInput::setVertices", false, vertexCount * sizeof(T)};
+        glNamedBufferData(VBO, vertexCount * sizeof(T), data.data(), usage);
+    }
+    // Switch to streaming mode, the data can then be changed every frame through `updateVertices`.
+    template <typename T>
+    void setStreamingVertices(const std::vector<T>& data)
+    {
+        if (mapped)
+        {
+            openglLogger.error("Streaming VBO can not be respecified.");
+            exit(-1);
+        }
+        if (instanceCount)
+        {
+            openglLogger.error("Instanced inputs do not stream, their per-instance data is static.");
+            exit(-1);
+        }
         vertexCount = data.size();
+        ProfileScope scope{"VertexInput::setStreamingVertices", false, streamRegions * data.size() * sizeof(T)};
+        shadow.resize(data.size() * sizeof(T));
+        std::memcpy(shadow.data(), data.data(), shadow.size());
 
-        bind();
-        bindVBO();
-        glBufferData(GL_ARRAY_BUFFER, vertexCount * sizeof(T), data.data(), usage);
-        unbind();
-        unbindVBO();
+        const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        glNamedBufferStorage(VBO, streamRegions * shadow.size(), nullptr, flags);
+        mapped = static_cast<GLubyte*>(glMapNamedBufferRange(VBO, 0, streamRegions * shadow.size(), flags));
+        if (mapped == nullptr)
+        {
+            openglLogger.error("Failed to map streaming VBO of {} bytes.", streamRegions * shadow.size());
+            exit(-1);
+        }
+        for (size_t i = 0; i < streamRegions; i++)
+        {
+            std::memcpy(mapped + i * shadow.size(), shadow.data(), shadow.size());
+        }
+    }
+    // Replace the vertices from `offset` on; the change reaches the GPU with the next draw.
+    template <std::ranges::contiguous_range R>
+    void updateVertices(size_t offset, const R& range)
+    {
+        using T = std::ranges::range_value_t<R>;
+        std::span<const T> data(range);
+        if (mapped == nullptr || (offset + data.size()) * sizeof(T) > shadow.size())
+        {
+            openglLogger.error("Vertices {} to {} are not in a streaming VBO.", offset, offset + data.size());
+            exit(-1);
+        }
+        size_t first = offset * sizeof(T), last = first + data.size_bytes();
+        std::memcpy(shadow.data() + first, data.data(), data.size_bytes());
+        for (auto& range: dirty)
+        {
+            range = range.first == range.second? std::pair{first, last}: std::pair{std::min(range.first, first), std::max(range.second, last)};
+        }
     }
     template <is_one_of<GLubyte, GLushort, GLuint> T>
     void setIndices(const std::vector<T>& data, GLenum usage = GL_STATIC_DRAW)
@@ -47,41 +157,39 @@ public:
         indexCount = data.size();
         indexType = gl_type_enum_v<T>;
 
-        bind();
-        bindEBO();
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexCount * sizeof(T), data.data(), usage);
-        unbind();
-        unbindEBO();
+        ProfileScope scope{"VertexInput::setIndices", false, indexCount * sizeof(T)};
+        glNamedBufferData(EBO, indexCount * sizeof(T), data.data(), usage);
     }
+    // Per-vertex attributes of `T`, in locations from 0 on.
     template <typename T, typename... U, typename... Members>
         requires (std::is_base_of_v<U, T> && ...) && (is_gl_type<typename GetArraySize<Members>::Type> && ...)
-    void loadMemoryModel(Members (U::* const... members)) const
+    void loadMemoryModel(Members (U::* const... members))
     {
-        bind();
-        bindVBO();
-        bindEBO();
-        GLuint index = 0;
-        (
-            (
-                glVertexAttribPointer(
-                    index,
-                    GetArraySize<Members>::Size,
-                    gl_type_enum_v<typename GetArraySize<Members>::Type>,
-                    GL_FALSE,
-                    sizeof(T),
-                    static_cast<const void*>(
-                        &(static_cast<T*>(nullptr)->*static_cast<Members T::*>(members))
-                    )
-                ),
-                glEnableVertexAttribArray(index++)
-            ), ...
-        );
-        unbind();
-        unbindVBO();
-        unbindEBO();
+        glVertexArrayVertexBuffer(VAO, vertexBinding, VBO, 0, sizeof(T));
+        vertexAttributes = loadAttributes<T>(VAO, 0, vertexBinding, members...);
+    }
+    // Per-instance attributes of `T`, in the locations following those of `loadMemoryModel`.
+    template <typename T, typename... U, typename... Members>
+        requires (std::is_base_of_v<U, T> && ...) && (is_gl_type<typename GetArraySize<Members>::Type> && ...)
+    void loadInstanceModel(Members (U::* const... members)) const
+    {
+        glVertexArrayVertexBuffer(VAO, instanceBinding, instanceVBO, 0, sizeof(T));
+        glVertexArrayBindingDivisor(VAO, instanceBinding, 1);
+        loadAttributes<T>(VAO, vertexAttributes, instanceBinding, members...);
+    }
+    template <typename T>
+    void setInstances(const std::vector<T>& data, GLenum usage = GL_STATIC_DRAW)
+    {
+        if (mapped)
+        {
+            openglLogger.error("Instanced inputs do not stream, their per-instance data is static.");
+            exit(-1);
+        }
+        instanceCount = data.size();
+
+        ProfileScope scope{"VertexInput::setInstances", false, instanceCount * sizeof(T)};
+        glNamedBufferData(instanceVBO, instanceCount * sizeof(T), data.data(), usage);
     }
-    void draw() const;
-    void bind() const;
-    void unbind() const;
+    void draw(const DrawList* = nullptr) const;
     ~VertexInput();
 };
\ No newline at end of file
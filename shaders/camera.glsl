@@ -5,4 +5,24 @@ struct Camera
     float hfov, d;
 };
 
-uniform Camera camera;
\ No newline at end of file
+// std140 block shared by every program and uploaded once per frame, see FrameBlock.
+layout (std140) uniform Frame
+{
+    Camera camera;
+    Camera prev_camera;
+};
+
+mat3 camera_rotation(Camera c)
+{
+    mat3 rot_camera_x = mat3(
+        cos(c.orientation.x), 0, sin(c.orientation.x),
+        0, 1, 0,
+        -sin(c.orientation.x), 0, cos(c.orientation.x)
+    );
+    mat3 rot_camera_y = mat3(
+        1, 0, 0,
+        0, cos(c.orientation.y), sin(c.orientation.y),
+        0, -sin(c.orientation.y), cos(c.orientation.y)
+    );
+    return rot_camera_y * rot_camera_x;
+}
@@ -0,0 +1,26 @@
+#version 330 core
+
+in vec2 texCoord;
+in vec3 world_position;
+flat in vec3 world_normal;
+flat in int cube_index;
+
+uniform sampler2D altas;
+
+// Attachments of GBuffer; position.w marks covered pixels.
+layout (location = 0) out vec4 position;
+layout (location = 1) out vec4 normal;
+layout (location = 2) out vec2 uv;
+layout (location = 3) out int index;
+
+void main()
+{
+    if (texture(altas, texCoord).a == 0)
+    {
+        discard;
+    }
+    position = vec4(world_position, 1.);
+    normal = vec4(normalize(world_normal), 0.);
+    uv = texCoord;
+    index = cube_index;
+}
\ No newline at end of file
@@ -16,6 +16,12 @@ in UV
 } uv_vs[];
 
 out vec2 texCoord;
+#ifdef GBUFFER
+flat in int cube_index_vs[];
+out vec3 world_position;
+flat out vec3 world_normal;
+flat out int cube_index;
+#endif
 
 #include camera.glsl
 
@@ -24,22 +30,42 @@ vec4 position(vec3 pos)
     return vec4(pos.xy, (pos.z - camera.d) * camera.hfov, (pos.z + camera.d) * camera.hfov);
 }
 
-void triangle(vec3 v1, vec3 v2, vec3 v3, vec2 t1, vec2 t2, vec2 t3)
+#ifdef GBUFFER
+// Normal of the face being emitted, in view space and not oriented.
+vec3 face_normal;
+
+// Undo the view transform of shaders/vertex.glsl.
+vec3 to_world(vec3 v)
 {
-    gl_Position = position(v1);
-    texCoord = t1;
-    EmitVertex();
-    gl_Position = position(v2);
-    texCoord = t2;
-    EmitVertex();
-    gl_Position = position(v3);
-    texCoord = t3;
+    return vec3(-v.x, v.y, v.z) * camera_rotation(camera);
+}
+#endif
+
+void emit(vec3 v, vec2 t)
+{
+    gl_Position = position(v);
+    texCoord = t;
+#ifdef GBUFFER
+    world_position = camera.position + to_world(v);
+    world_normal = to_world(face_normal);
+    cube_index = cube_index_vs[0];
+#endif
     EmitVertex();
+}
+
+void triangle(vec3 v1, vec3 v2, vec3 v3, vec2 t1, vec2 t2, vec2 t3)
+{
+    emit(v1, t1);
+    emit(v2, t2);
+    emit(v3, t3);
     EndPrimitive();
 }
 
 void face(vec3 origin, vec3 edge_x, vec3 edge_y, vec4 uv)
 {
+#ifdef GBUFFER
+    face_normal = normalize(cross(edge_x, edge_y));
+#endif
     triangle(origin, origin + edge_x, origin + edge_x + edge_y,
         uv.xy, uv.xy + vec2(uv.z, 0), uv.xy + uv.zw);
     triangle(origin + edge_x + edge_y, origin + edge_y, origin,
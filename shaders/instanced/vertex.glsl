@@ -0,0 +1,46 @@
+#version 330 core
+
+// Unit cube mesh, per vertex.
+layout (location = 0) in vec3 corner;
+layout (location = 1) in vec2 face_coord;
+layout (location = 2) in float face;
+// Cube, per instance.
+layout (location = 3) in vec3 origin;
+layout (location = 4) in vec3 size;
+layout (location = 5) in vec4 cube_rotation;
+layout (location = 6) in vec4 uv_east;
+layout (location = 7) in vec4 uv_south;
+layout (location = 8) in vec4 uv_west;
+layout (location = 9) in vec4 uv_north;
+layout (location = 10) in vec4 uv_up;
+layout (location = 11) in vec4 uv_down;
+
+out vec2 texCoord;
+
+#include ../camera.glsl
+
+// Packed cubes (see Cube) carry snorm16 rotations and UV rects in atlas texels.
+uniform bool packed_rotation;
+uniform bool packed_uv;
+uniform sampler2D altas;
+
+void main()
+{
+    vec4 rotation = packed_rotation? cube_rotation / 32767.: cube_rotation;
+    mat3 rot_cube = mat3(
+        1 - 2 * (rotation.y * rotation.y + rotation.z * rotation.z), 2 * (rotation.x * rotation.y + rotation.z * rotation.w), 2 * (rotation.x * rotation.z - rotation.y * rotation.w),
+        2 * (rotation.x * rotation.y - rotation.z * rotation.w), 1 - 2 * (rotation.x * rotation.x + rotation.z * rotation.z), 2 * (rotation.y * rotation.z + rotation.x * rotation.w),
+        2 * (rotation.x * rotation.z + rotation.y * rotation.w), 2 * (rotation.y * rotation.z - rotation.x * rotation.w), 1 - 2 * (rotation.x * rotation.x + rotation.y * rotation.y)
+    );
+    vec3 world = origin + rot_cube * (corner * size);
+    vec3 pos = camera_rotation(camera) * (world - camera.position);
+    gl_Position = vec4(-pos.x, pos.y, (pos.z - camera.d) * camera.hfov, (pos.z + camera.d) * camera.hfov);
+
+    vec4 uvs[6] = vec4[](uv_east, uv_south, uv_west, uv_north, uv_up, uv_down);
+    vec4 uv = uvs[int(face)];
+    if (packed_uv)
+    {
+        uv /= vec2(textureSize(altas, 0)).xyxy;
+    }
+    texCoord = uv.xy + face_coord * uv.zw;
+}
\ No newline at end of file
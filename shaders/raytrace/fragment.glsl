@@ -6,17 +6,19 @@ in Ray_VS
     vec3 direction;
 } initial_ray;
 
-struct Cube
-{
-    sampler2D origin_size;
-    sampler2D rotation;
-    sampler2D uv;
-    sampler2D material;
-};
+#include scene.glsl
+#include ../camera.glsl
+
+// Radiance (rgb) with its accumulated frame count (a), and first-hit ray parameter of the previous frame.
+uniform sampler2D history_radiance;
+uniform sampler2D history_depth;
+uniform vec2 history_offset;
+uniform vec2 history_size;
+uniform float max_history;
+uniform int frame_index;
 
-uniform Cube cube;
-uniform sampler2D altas;
-uniform int count;
+layout (location = 0) out vec4 radiance;
+layout (location = 1) out float depth;
 
 struct Ray
 {
@@ -25,19 +27,19 @@ struct Ray
     vec4 color;
 };
 
-#define INF_F 114514.f
-#define EPSILON 1e-3f
+// Tuning knobs, each may be overridden per program variant, see ShaderDefines.
+#ifndef SAMPLE_COUNT
+#define SAMPLE_COUNT 10
+#endif
+#ifndef MAX_BOUNCES
+#define MAX_BOUNCES 5
+#endif
 
 float seed;
 
-mat3 diag(vec3 v)
-{
-    return mat3(
-        v.x, 0, 0,
-        0, v.y, 0,
-        0, 0, v.z
-    );
-}
+// Ray parameter of the first surface seen by the first sample, summed across fully transparent texels.
+float primary_depth;
+bool primary_open;
 
 float random()
 {
@@ -46,127 +48,46 @@ float random()
     return fract(sin(seed) * 43758.5453);
 }
 
-void check_hit(inout Ray ray, out bool is_hit)
+// A surface a path reached; `k` is its ray parameter, INF_F when the ray escaped.
+struct Hit
 {
-    float k_min = INF_F;
-    vec4 color;
+    float k;
+    vec3 position;
     vec3 normal;
+    vec4 color;
     float glow;
     float metallic;
-    for (int index = 0; index < count; index++)
+};
+
+Hit find_hit(Ray ray)
+{
+    CubeHit cube_hit = intersect(ray.origin, ray.direction);
+    Hit hit;
+    hit.k = cube_hit.k;
+    if (cube_hit.k != INF_F)
     {
-        int i = index % 128, j = index / 128;
-        vec3 cube_origin = texelFetch(cube.origin_size, ivec2(i * 2, j), 0).rgb;
-        vec3 cube_size = texelFetch(cube.origin_size, ivec2(i * 2 + 1, j), 0).rgb;
-        vec4 cube_rotation = texelFetch(cube.rotation, ivec2(i, j), 0);
-        vec4 cube_uv_east = texelFetch(cube.uv, ivec2(i * 6, j), 0);
-        vec4 cube_uv_south = texelFetch(cube.uv, ivec2(i * 6 + 1, j), 0);
-        vec4 cube_uv_west = texelFetch(cube.uv, ivec2(i * 6 + 2, j), 0);
-        vec4 cube_uv_north = texelFetch(cube.uv, ivec2(i * 6 + 3, j), 0);
-        vec4 cube_uv_up = texelFetch(cube.uv, ivec2(i * 6 + 4, j), 0);
-        vec4 cube_uv_down = texelFetch(cube.uv, ivec2(i * 6 + 5, j), 0);
-        float cube_glow = texelFetch(cube.material, ivec2(i, j), 0).r;
-        float cube_metallic = texelFetch(cube.material, ivec2(i, j), 0).g;
-
-        vec4 q = cube_rotation;
-        mat3 rot_cube = 2 * mat3(
-            1 - q.y * q.y - q.z * q.z, q.x * q.y + q.z * q.w, q.x * q.z - q.y * q.w,
-            q.x * q.y - q.z * q.w, 1 - q.x * q.x - q.z * q.z, q.y * q.z + q.x * q.w,
-            q.x * q.z + q.y * q.w, q.y * q.z - q.x * q.w, 1 - q.x * q.x - q.y * q.y
-        ) - diag(vec3(1));
-        
-        vec3 ori_rel = (ray.origin - cube_origin) * rot_cube;
-        vec3 dir_rel = ray.direction * rot_cube;
-
-        vec3 k = - ori_rel / dir_rel;
-        vec3 k1 = k + cube_size / dir_rel;
-
-        if (k.z > EPSILON && k.z < k_min)
-        {
-            vec2 colli = ori_rel.xy + k.z * dir_rel.xy;
-            if (all(greaterThan(colli, vec2(0))) && all(lessThan(colli, cube_size.xy)))
-            {
-                vec2 tex_coord = colli / cube_size.xy;
-                tex_coord = vec2(1. - tex_coord.x, 1. - tex_coord.y);
-                color = texture(altas, cube_uv_north.xy + tex_coord * cube_uv_north.zw);
-                k_min = k.z;
-                normal = vec3(0., 0., -1.) * rot_cube;
-                glow = cube_glow;
-                metallic = cube_metallic;
-            }
-        }
-        if (k1.z > EPSILON && k1.z < k_min)
-        {
-            vec2 colli = ori_rel.xy + k1.z * dir_rel.xy;
-            if (all(greaterThan(colli, vec2(0))) && all(lessThan(colli, cube_size.xy)))
-            {
-                vec2 tex_coord = colli / cube_size.xy;
-                tex_coord = vec2(tex_coord.x, 1. - tex_coord.y);
-                color = texture(altas, cube_uv_south.xy + tex_coord * cube_uv_south.zw);
-                k_min = k1.z;
-                normal = vec3(0., 0., 1.) * rot_cube;
-                glow = cube_glow;
-                metallic = cube_metallic;
-            }
-        }
-        if (k.y > EPSILON && k.y < k_min)
-        {
-            vec2 colli = ori_rel.xz + k.y * dir_rel.xz;
-            if (all(greaterThan(colli, vec2(0))) && all(lessThan(colli, cube_size.xz)))
-            {
-                vec2 tex_coord = colli / cube_size.xz;
-                tex_coord = vec2(1. - tex_coord.x, tex_coord.y);
-                color = texture(altas, cube_uv_down.xy + tex_coord * cube_uv_down.zw);
-                k_min = k.y;
-                normal = vec3(0., -1., 0.) * rot_cube;
-                glow = cube_glow;
-                metallic = cube_metallic;
-            }
-        }
-        if (k1.y > EPSILON && k1.y < k_min)
-        {
-            vec2 colli = ori_rel.xz + k1.y * dir_rel.xz;
-            if (all(greaterThan(colli, vec2(0))) && all(lessThan(colli, cube_size.xz)))
-            {
-                vec2 tex_coord = colli / cube_size.xz;
-                tex_coord = vec2(1. - tex_coord.x, 1. - tex_coord.y);
-                color = texture(altas, cube_uv_up.xy + tex_coord * cube_uv_up.zw);
-                k_min = k1.y;
-                normal = vec3(0., 1., 0.) * rot_cube;
-                glow = cube_glow;
-                metallic = cube_metallic;
-            }
-        }
-        if (k.x > EPSILON && k.x < k_min)
-        {
-            vec2 colli = ori_rel.yz + k.x * dir_rel.yz;
-            if (all(greaterThan(colli, vec2(0))) && all(lessThan(colli, cube_size.yz)))
-            {
-                vec2 tex_coord = colli / cube_size.yz;
-                tex_coord = vec2(tex_coord.y, 1. - tex_coord.x);
-                color = texture(altas, cube_uv_west.xy + tex_coord * cube_uv_west.zw);
-                k_min = k.x;
-                normal = vec3(-1., 0., 0.) * rot_cube;
-                glow = cube_glow;
-                metallic = cube_metallic;
-            }
-        }
-        if (k1.x > EPSILON && k1.x < k_min)
-        {
-            vec2 colli = ori_rel.yz + k1.x * dir_rel.yz;
-            if (all(greaterThan(colli, vec2(0))) && all(lessThan(colli, cube_size.yz)))
-            {
-                vec2 tex_coord = colli / cube_size.yz;
-                tex_coord = vec2(1. - tex_coord.y, 1. - tex_coord.x);
-                color = texture(altas, cube_uv_east.xy + tex_coord * cube_uv_east.zw);
-                k_min = k1.x;
-                normal = vec3(1., 0., 0.) * rot_cube;
-                glow = cube_glow;
-                metallic = cube_metallic;
-            }
-        }
+        hit.position = ray.origin + cube_hit.k * ray.direction;
+        hit.normal = cube_normal(cube_hit.base, cube_hit.face);
+        vec4 uv = cube_uv(cube_hit.base, cube_hit.face);
+        hit.color = texture(altas, uv.xy + cube_hit.tex_coord * uv.zw);
+        vec2 material = cube_material(cube_hit.base);
+        hit.glow = material.x;
+        hit.metallic = material.y;
     }
-    if (k_min == INF_F)
+    return hit;
+}
+
+// Continue the path at `hit`: it ends on escape or at a light, crosses transparent texels, reflects or scatters.
+void scatter(inout Ray ray, Hit hit, out bool is_hit)
+{
+    vec4 color = hit.color;
+    vec3 normal = hit.normal;
+    if (primary_open)
+    {
+        primary_depth += hit.k;
+        primary_open = hit.k != INF_F && color.a == 0;
+    }
+    if (hit.k == INF_F)
     {
         is_hit = false;
         // float cos_angle = dot(normalize(ray.direction), vec3(-0.6, 0.8, 0.));
@@ -180,22 +101,22 @@ void check_hit(inout Ray ray, out bool is_hit)
         if (color.a == 0)
         {
             is_hit = true;
-            ray.origin = ray.origin + k_min * ray.direction;
+            ray.origin = hit.position;
             return;
         }
-        if (random() < glow)
+        if (random() < hit.glow)
         {
             is_hit = false;
-            if (glow > 1) color *= glow;
+            if (hit.glow > 1) color *= hit.glow;
             ray.color *= color;
             return;
         }
         is_hit = true;
-        ray.origin = ray.origin + k_min * ray.direction;
-        if (random() < metallic)
+        ray.origin = hit.position;
+        if (random() < hit.metallic)
         {
             ray.direction = ray.direction - 2. * dot(normal, ray.direction) * normal;
-            if (metallic > 1) color = mix(color, vec4(1.), 1 / metallic);
+            if (hit.metallic > 1) color = mix(color, vec4(1.), 1 / hit.metallic);
             ray.color *= color;
             return;
         }
@@ -211,14 +132,92 @@ void check_hit(inout Ray ray, out bool is_hit)
     }
 }
 
-#define SAMPLE_COUNT 10
+#ifdef HYBRID
+// Rasterized first hits, see GBuffer; transparent texels were discarded there, so this is the first visible surface.
+uniform sampler2D gbuffer_position;
+uniform sampler2D gbuffer_normal;
+uniform sampler2D gbuffer_uv;
+uniform isampler2D gbuffer_index;
+
+Hit primary_hit()
+{
+    ivec2 texel = ivec2(gl_FragCoord.xy);
+    vec4 position = texelFetch(gbuffer_position, texel, 0);
+    Hit hit;
+    hit.k = INF_F;
+    if (position.w == 0.)
+    {
+        return hit;
+    }
+    vec3 offset = position.xyz - initial_ray.origin;
+    hit.k = dot(offset, initial_ray.direction) / dot(initial_ray.direction, initial_ray.direction);
+    hit.position = position.xyz;
+    hit.normal = texelFetch(gbuffer_normal, texel, 0).xyz;
+    hit.color = texture(altas, texelFetch(gbuffer_uv, texel, 0).xy);
+    vec2 material = cube_material(texelFetch(gbuffer_index, texel, 0).r * cube_texels);
+    hit.glow = material.x;
+    hit.metallic = material.y;
+    return hit;
+}
+#endif
+
+// Previous frame's radiance at the point `t` along the initial ray, or zero weight when it was not visible there.
+vec4 reproject(float t)
+{
+    mat3 rot_camera = camera_rotation(prev_camera);
+    vec3 prev_origin = prev_camera.position - vec3(0., 0., prev_camera.d) * rot_camera;
+    vec3 prev_ray;
+    if (t >= INF_F)
+    {
+        prev_ray = rot_camera * initial_ray.direction;
+    }
+    else
+    {
+        prev_ray = rot_camera * (initial_ray.origin + t * initial_ray.direction - prev_origin);
+    }
+    if (prev_ray.z < EPSILON)
+    {
+        return vec4(0.);
+    }
+    vec2 coord = prev_ray.xy / (prev_ray.z * prev_camera.hfov);
+    vec2 uv = vec2(-coord.x, coord.y) * 0.5 + 0.5;
+    if (any(lessThan(uv, vec2(0.))) || any(greaterThanEqual(uv, vec2(1.))))
+    {
+        return vec4(0.);
+    }
+    ivec2 texel = ivec2(uv * history_size + history_offset);
+    if (any(lessThan(texel, ivec2(0))) || any(greaterThanEqual(texel, textureSize(history_depth, 0))))
+    {
+        return vec4(0.);
+    }
+    float prev_t = texelFetch(history_depth, texel, 0).r;
+    if (t >= INF_F)
+    {
+        if (prev_t < INF_F)
+        {
+            return vec4(0.);
+        }
+    }
+    else if (abs(prev_t - prev_ray.z) > 0.02 * prev_ray.z + EPSILON)
+    {
+        // Disocclusion: another surface covered this pixel in the previous frame.
+        return vec4(0.);
+    }
+    return texelFetch(history_radiance, texel, 0);
+}
 
 void main()
 {
-    seed = dot(initial_ray.direction, vec3(1.14, 5.14, 19.19));
+    seed = dot(initial_ray.direction, vec3(1.14, 5.14, 19.19)) + float(frame_index % 1024) * 0.618034;
     seed = random();
+    primary_depth = 0.;
+    primary_open = true;
     Ray ray;
     vec4 final_color = vec4(0.);
+#ifdef HYBRID
+    // Every sample shares the initial ray, so its first hit is looked up once.
+    Hit first_hit = primary_hit();
+#endif
     for (int j = 0; j < SAMPLE_COUNT; j++)
     {
         ray.origin = initial_ray.origin;
@@ -227,9 +226,13 @@ void main()
 
 
         bool is_hit = true;
-        for (int i = 0; i < 5 && is_hit; i++)
+        for (int i = 0; i < MAX_BOUNCES && is_hit; i++)
         {
-            check_hit(ray, is_hit);
+#ifdef HYBRID
+            scatter(ray, i == 0? first_hit: find_hit(ray), is_hit);
+#else
+            scatter(ray, find_hit(ray), is_hit);
+#endif
             float prob = max(max(ray.color.r, ray.color.g), ray.color.b);
             if (random() > prob)
             {
@@ -241,8 +244,18 @@ void main()
         {
             ray.color *= vec4(0., 0., 0., 1.);
         }
+        if (primary_open)
+        {
+            // Only transparent texels were crossed before the path ended.
+            primary_depth = INF_F;
+            primary_open = false;
+        }
         final_color += ray.color;
     }
     final_color /= SAMPLE_COUNT;
-    gl_FragColor = final_color;
+
+    vec4 history = max_history > 0.? reproject(primary_depth): vec4(0.);
+    float weight = min(history.a, max_history);
+    radiance = vec4(mix(history.rgb, final_color.rgb, 1. / (weight + 1.)), weight + 1.);
+    depth = primary_depth;
 }
\ No newline at end of file
@@ -0,0 +1,150 @@
+// Scene access shared by the fragment ray tracer and the wavefront kernels, see RayTraceScene.
+
+// One record of cube_texels texels per cube, see TextureCube: three rows of the world-to-unit-box transform,
+// then from shading_texel on the uv rects (east, south, west, north, up, down) and the material.
+// Packed records hold uv rects in atlas texels and the material as 4.4 fixed-point bytes.
+uniform usamplerBuffer cubes;
+uniform sampler2D altas;
+uniform int count;
+uniform int cube_texels;
+uniform int shading_texel;
+uniform bool packed_uv;
+
+#define INF_F 114514.f
+// May be overridden per program variant, see ShaderDefines.
+#ifndef EPSILON
+#define EPSILON 1e-3f
+#endif
+
+// Sign-extends the two 16-bit halves of each word, low half first.
+ivec4 unpack_short4(uvec2 words)
+{
+    return ivec4(int(words.x << 16) >> 16, int(words.x) >> 16, int(words.y << 16) >> 16, int(words.y) >> 16);
+}
+
+vec4 cube_uv(int base, int face)
+{
+    if (packed_uv)
+    {
+        uvec4 texel = texelFetch(cubes, base + shading_texel + face / 2);
+        return vec4(unpack_short4(face % 2 == 0? texel.xy: texel.zw)) / vec2(textureSize(altas, 0)).xyxy;
+    }
+    return uintBitsToFloat(texelFetch(cubes, base + shading_texel + face));
+}
+
+vec2 cube_material(int base)
+{
+    if (packed_uv)
+    {
+        uint word = texelFetch(cubes, base + shading_texel + 3).x;
+        return vec2(float(word & 0xffu), float((word >> 8) & 0xffu)) / 16.;
+    }
+    return uintBitsToFloat(texelFetch(cubes, base + shading_texel + 6).xy);
+}
+
+// Unit normal of `face`: transform rows are the cube axes scaled by the inverse size.
+vec3 cube_normal(int base, int face)
+{
+    int axis = face == 0 || face == 2? 0: face == 4 || face == 5? 1: 2;
+    vec3 row = uintBitsToFloat(texelFetch(cubes, base + axis)).xyz;
+    return normalize(face == 0 || face == 1 || face == 4? row: -row);
+}
+
+// Closest face along a ray: `base` is the record's first texel, faces are numbered as in cube_uv.
+// `k` is INF_F when nothing is hit.
+struct CubeHit
+{
+    float k;
+    int base;
+    int face;
+    vec2 tex_coord;
+};
+
+CubeHit intersect(vec3 origin, vec3 direction)
+{
+    CubeHit hit;
+    hit.k = INF_F;
+    for (int base = 0; base < count * cube_texels; base += cube_texels)
+    {
+        mat3x4 to_cube = mat3x4(
+            uintBitsToFloat(texelFetch(cubes, base)),
+            uintBitsToFloat(texelFetch(cubes, base + 1)),
+            uintBitsToFloat(texelFetch(cubes, base + 2))
+        );
+        vec3 ori_rel = vec4(origin, 1.) * to_cube;
+        vec3 dir_rel = vec4(direction, 0.) * to_cube;
+
+        // Slabs of the unit box: k reaches the faces at 0, k1 those at 1.
+        vec3 inv_dir = 1. / dir_rel;
+        vec3 k = - ori_rel * inv_dir;
+        vec3 k1 = k + inv_dir;
+
+        if (k.z > EPSILON && k.z < hit.k)
+        {
+            vec2 colli = ori_rel.xy + k.z * dir_rel.xy;
+            if (all(greaterThan(colli, vec2(0))) && all(lessThan(colli, vec2(1))))
+            {
+                hit.tex_coord = vec2(1. - colli.x, 1. - colli.y);
+                hit.face = 3;
+                hit.k = k.z;
+                hit.base = base;
+            }
+        }
+        if (k1.z > EPSILON && k1.z < hit.k)
+        {
+            vec2 colli = ori_rel.xy + k1.z * dir_rel.xy;
+            if (all(greaterThan(colli, vec2(0))) && all(lessThan(colli, vec2(1))))
+            {
+                hit.tex_coord = vec2(colli.x, 1. - colli.y);
+                hit.face = 1;
+                hit.k = k1.z;
+                hit.base = base;
+            }
+        }
+        if (k.y > EPSILON && k.y < hit.k)
+        {
+            vec2 colli = ori_rel.xz + k.y * dir_rel.xz;
+            if (all(greaterThan(colli, vec2(0))) && all(lessThan(colli, vec2(1))))
+            {
+                hit.tex_coord = vec2(1. - colli.x, colli.y);
+                hit.face = 5;
+                hit.k = k.y;
+                hit.base = base;
+            }
+        }
+        if (k1.y > EPSILON && k1.y < hit.k)
+        {
+            vec2 colli = ori_rel.xz + k1.y * dir_rel.xz;
+            if (all(greaterThan(colli, vec2(0))) && all(lessThan(colli, vec2(1))))
+            {
+                hit.tex_coord = vec2(1. - colli.x, 1. - colli.y);
+                hit.face = 4;
+                hit.k = k1.y;
+                hit.base = base;
+            }
+        }
+        if (k.x > EPSILON && k.x < hit.k)
+        {
+            vec2 colli = ori_rel.yz + k.x * dir_rel.yz;
+            if (all(greaterThan(colli, vec2(0))) && all(lessThan(colli, vec2(1))))
+            {
+                hit.tex_coord = vec2(colli.y, 1. - colli.x);
+                hit.face = 2;
+                hit.k = k.x;
+                hit.base = base;
+            }
+        }
+        if (k1.x > EPSILON && k1.x < hit.k)
+        {
+            vec2 colli = ori_rel.yz + k1.x * dir_rel.yz;
+            if (all(greaterThan(colli, vec2(0))) && all(lessThan(colli, vec2(1))))
+            {
+                hit.tex_coord = vec2(1. - colli.y, 1. - colli.x);
+                hit.face = 0;
+                hit.k = k1.x;
+                hit.base = base;
+            }
+        }
+    }
+    return hit;
+}
\ No newline at end of file
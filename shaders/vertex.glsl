@@ -2,7 +2,7 @@
 
 layout (location = 0) in vec3 origin;
 layout (location = 1) in vec3 size;
-layout (location = 2) in vec4 rotation;
+layout (location = 2) in vec4 cube_rotation;
 layout (location = 3) in vec4 uv_east;
 layout (location = 4) in vec4 uv_south;
 layout (location = 5) in vec4 uv_west;
@@ -21,9 +21,18 @@ out UV
     vec4 up;
     vec4 down;
 } uv_vs;
+#ifdef GBUFFER
+// Index into the cube array and the ray tracer's cube table, which share one order.
+flat out int cube_index_vs;
+#endif
 
 #include camera.glsl
 
+// Packed cubes (see Cube) carry snorm16 rotations and UV rects in atlas texels.
+uniform bool packed_rotation;
+uniform bool packed_uv;
+uniform sampler2D altas;
+
 mat3 diag(vec3 v)
 {
     return mat3(
@@ -35,29 +44,24 @@ mat3 diag(vec3 v)
 
 void main()
 {
+    vec4 rotation = packed_rotation? cube_rotation / 32767.: cube_rotation;
+    vec4 uv_scale = packed_uv? 1. / vec2(textureSize(altas, 0)).xyxy: vec4(1.);
     mat3 rot_cube = 2 * mat3(
         1 - rotation.y * rotation.y - rotation.z * rotation.z, rotation.x * rotation.y + rotation.z * rotation.w, rotation.x * rotation.z - rotation.y * rotation.w,
         rotation.x * rotation.y - rotation.z * rotation.w, 1 - rotation.x * rotation.x - rotation.z * rotation.z, rotation.y * rotation.z + rotation.x * rotation.w,
         rotation.x * rotation.z + rotation.y * rotation.w, rotation.y * rotation.z - rotation.x * rotation.w, 1 - rotation.x * rotation.x - rotation.y * rotation.y
     ) - diag(vec3(1));
-    mat3 rot_camera_x = mat3(
-        cos(camera.orientation.x), 0, sin(camera.orientation.x),
-        0, 1, 0,
-        -sin(camera.orientation.x), 0, cos(camera.orientation.x)
-    );
-    mat3 rot_camera_y = mat3(
-        1, 0, 0,
-        0, cos(camera.orientation.y), sin(camera.orientation.y),
-        0, -sin(camera.orientation.y), cos(camera.orientation.y)
-    );
-    mat3 rot_camera = rot_camera_y * rot_camera_x;
+    mat3 rot_camera = camera_rotation(camera);
     mat3 transform = diag(vec3(-1, 1, 1));
     origin_vs   = transform * rot_camera * (origin - camera.position);
     edges_vs    = transform * rot_camera * rot_cube * diag(size);
-    uv_vs.east  = uv_east;
-    uv_vs.south = uv_south;
-    uv_vs.west  = uv_west;
-    uv_vs.north = uv_north;
-    uv_vs.up    = uv_up;
-    uv_vs.down  = uv_down;
+    uv_vs.east  = uv_east * uv_scale;
+    uv_vs.south = uv_south * uv_scale;
+    uv_vs.west  = uv_west * uv_scale;
+    uv_vs.north = uv_north * uv_scale;
+    uv_vs.up    = uv_up * uv_scale;
+    uv_vs.down  = uv_down * uv_scale;
+#ifdef GBUFFER
+    cube_index_vs = gl_VertexID;
+#endif
 }
\ No newline at end of file
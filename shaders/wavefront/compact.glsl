@@ -0,0 +1,31 @@
+#version 430 core
+
+#include path.glsl
+
+layout (local_size_x = GROUP_SIZE) in;
+
+shared uint group_count;
+shared uint group_first;
+
+// Append the paths still alive to the next queue, reserving one range per work group.
+void main()
+{
+    if (gl_LocalInvocationIndex == 0)
+    {
+        group_count = 0u;
+    }
+    barrier();
+    uint i = gl_GlobalInvocationID.x;
+    bool alive = i < queue_size && current_paths[i].hit_k >= 0.;
+    uint slot = alive? atomicAdd(group_count, 1u): 0u;
+    barrier();
+    if (gl_LocalInvocationIndex == 0)
+    {
+        group_first = atomicAdd(next_queue_size, group_count);
+    }
+    barrier();
+    if (alive)
+    {
+        next_paths[group_first + slot] = current_paths[i];
+    }
+}
\ No newline at end of file
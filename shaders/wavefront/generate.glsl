@@ -0,0 +1,32 @@
+#version 430 core
+
+layout (local_size_x = 8, local_size_y = 8) in;
+
+#include ../camera.glsl
+#include path.glsl
+
+uniform int sample_index;
+
+// One primary path per pixel, through the pixel center as in shaders/raytrace/vertex.glsl.
+void main()
+{
+    ivec2 texel = ivec2(gl_GlobalInvocationID.xy);
+    if (any(greaterThanEqual(texel, size)))
+    {
+        return;
+    }
+    vec2 coord = (vec2(texel) + 0.5) / vec2(size) * 2. - 1.;
+    coord.x = -coord.x;
+    mat3 rot_camera = camera_rotation(camera);
+
+    Path path;
+    path.origin.xyz = camera.position - vec3(0., 0., camera.d) * rot_camera;
+    path.direction = vec4(vec3(coord * camera.hfov, 1.) * rot_camera, 0.);
+    path.color = vec4(1.);
+    path.pixel = uint(texel.y * size.x + texel.x);
+    float seed = dot(path.direction.xyz, vec3(1.14, 5.14, 19.19)) + float(sample_index % 1024) * 0.618034;
+    path.origin.w = random(seed);
+    current_paths[path.pixel] = path;
+
+    imageStore(radiance, texel, imageLoad(radiance, texel) + vec4(0., 0., 0., 1.));
+}
\ No newline at end of file
@@ -0,0 +1,25 @@
+#version 430 core
+
+#include ../raytrace/scene.glsl
+#include path.glsl
+
+layout (local_size_x = GROUP_SIZE) in;
+
+// Closest hit of every queued path; only the scan, shading waits for the next kernel.
+void main()
+{
+    if (gl_LocalInvocationIndex == 0)
+    {
+        uint first = gl_WorkGroupID.x * GROUP_SIZE;
+        atomicAdd(ray_casts, min(uint(GROUP_SIZE), queue_size - first));
+    }
+    uint i = gl_GlobalInvocationID.x;
+    if (i >= queue_size)
+    {
+        return;
+    }
+    CubeHit hit = intersect(current_paths[i].origin.xyz, current_paths[i].direction.xyz);
+    current_paths[i].hit_k = hit.k;
+    current_paths[i].hit = hit.base * 8 + hit.face;
+    current_paths[i].hit_tex_coord = hit.tex_coord;
+}
\ No newline at end of file
@@ -0,0 +1,45 @@
+// Path queues shared by the wavefront kernels, see WavefrontTracer. GROUP_SIZE is defined by the host.
+
+// One path segment waiting to be traced; 80 bytes in std430.
+struct Path
+{
+    vec4 origin;        // w: random seed
+    vec4 direction;
+    vec4 color;
+    vec2 hit_tex_coord;
+    float hit_k;        // Ray parameter of the hit, INF_F on escape, negative once the path ended.
+    int hit;            // First texel of the cube record times 8, plus the face.
+    uint pixel;
+};
+
+layout (std430, binding = 0) buffer CurrentQueue
+{
+    Path current_paths[];
+};
+
+layout (std430, binding = 1) buffer NextQueue
+{
+    Path next_paths[];
+};
+
+// The first three words are the indirect dispatch covering the current queue.
+layout (std430, binding = 2) buffer Counters
+{
+    uint groups_x, groups_y, groups_z;
+    uint queue_size;
+    uint next_queue_size;
+    uint ray_casts;
+};
+
+// Sum of the sample radiance reaching each pixel, alpha counts the samples.
+layout (binding = 0, rgba32f) uniform image2D radiance;
+
+uniform ivec2 size;
+
+// Same sequence as random() in shaders/raytrace/fragment.glsl, with the seed carried by the path.
+float random(inout float seed)
+{
+    seed += 5.14114;
+    if (seed > 100) seed *= -1;
+    return fract(sin(seed) * 43758.5453);
+}
\ No newline at end of file
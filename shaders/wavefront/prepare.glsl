@@ -0,0 +1,13 @@
+#version 430 core
+
+#include path.glsl
+
+layout (local_size_x = 1) in;
+
+// Make the compacted queue current and size the next indirect dispatches to it.
+void main()
+{
+    queue_size = next_queue_size;
+    next_queue_size = 0u;
+    groups_x = (queue_size + GROUP_SIZE - 1) / GROUP_SIZE;
+}
\ No newline at end of file
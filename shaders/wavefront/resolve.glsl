@@ -0,0 +1,18 @@
+#version 430 core
+
+#include path.glsl
+
+layout (local_size_x = 8, local_size_y = 8) in;
+
+layout (binding = 1, rgba8) uniform writeonly image2D result;
+
+void main()
+{
+    ivec2 texel = ivec2(gl_GlobalInvocationID.xy);
+    if (any(greaterThanEqual(texel, size)))
+    {
+        return;
+    }
+    vec4 sum = imageLoad(radiance, texel);
+    imageStore(result, texel, vec4(sum.rgb / max(sum.a, 1.), 1.));
+}
\ No newline at end of file
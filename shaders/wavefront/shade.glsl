@@ -0,0 +1,77 @@
+#version 430 core
+
+#include ../raytrace/scene.glsl
+#include path.glsl
+
+layout (local_size_x = GROUP_SIZE) in;
+
+// Material response at every hit, as scatter() in shaders/raytrace/fragment.glsl: escaped paths end dark,
+// lights end the path and add to the pixel, the rest cross, reflect or scatter and face russian roulette.
+void main()
+{
+    uint i = gl_GlobalInvocationID.x;
+    if (i >= queue_size)
+    {
+        return;
+    }
+    Path path = current_paths[i];
+    float seed = path.origin.w;
+    bool alive = false;
+    if (path.hit_k != INF_F)
+    {
+        int base = path.hit >> 3;
+        int face = path.hit & 7;
+        vec4 uv = cube_uv(base, face);
+        // No derivatives in compute shaders, the atlas is sampled at its base level.
+        vec4 color = textureLod(altas, uv.xy + path.hit_tex_coord * uv.zw, 0.);
+        vec2 material = cube_material(base);
+        float glow = material.x;
+        float metallic = material.y;
+        path.origin.xyz += path.hit_k * path.direction.xyz;
+        alive = true;
+        if (color.a == 0)
+        {
+            // Fully transparent texel, crossed in the same direction.
+        }
+        else if (random(seed) < glow)
+        {
+            if (glow > 1) color *= glow;
+            path.color *= color;
+            ivec2 texel = ivec2(path.pixel % uint(size.x), path.pixel / uint(size.x));
+            imageStore(radiance, texel, imageLoad(radiance, texel) + vec4(path.color.rgb, 0.));
+            alive = false;
+        }
+        else
+        {
+            vec3 normal = cube_normal(base, face);
+            vec3 direction = path.direction.xyz;
+            if (random(seed) < metallic)
+            {
+                direction = direction - 2. * dot(normal, direction) * normal;
+                if (metallic > 1) color = mix(color, vec4(1.), 1 / metallic);
+            }
+            else
+            {
+                float direction_normal = random(seed);
+                vec3 x = vec3(normal.z, 0., -normal.x);
+                vec3 y = vec3(0., normal.z, -normal.y);
+                vec3 tan1 = normalize(length(x) > length(y)? x: y);
+                vec3 tan2 = cross(normal, tan1);
+                float angle = random(seed) * 3.14159265358979 * 2;
+                if (dot(normal, direction) > 0) direction_normal = - direction_normal;
+                direction = direction_normal * normal + cos(angle) * tan1 + sin(angle) * tan2;
+            }
+            path.direction.xyz = direction;
+            path.color *= color;
+        }
+        if (alive)
+        {
+            float prob = max(max(path.color.r, path.color.g), path.color.b);
+            alive = random(seed) <= prob;
+            path.color /= prob;
+        }
+    }
+    path.origin.w = seed;
+    path.hit_k = alive? path.hit_k: -1.;
+    current_paths[i] = path;
+}
\ No newline at end of file
@@ -0,0 +1,162 @@
+#include "synthetic_scene.hpp"
+#include "../model/scene.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <functional>
+#include <json/json.h>
+
+// Micro benchmarks of the CPU side of scene loading on generated scenes of growing size. Every case runs until
+// it has taken `min_time` and at least `min_runs` runs after a warm-up run; the median run is reported.
+static const Logger bench_logger{"Bench"};
+
+static const double min_time = 0.5;
+static const int min_runs = 5;
+
+// Keeps results alive so the optimizer cannot drop the work producing them.
+static volatile double sink;
+
+static Json::Value measure(const std::string& name, double size, const std::function<void()>& run)
+{
+    using Clock = std::chrono::steady_clock;
+    run();
+    std::vector<double> times;
+    double total = 0.;
+    while (total < min_time || (int)times.size() < min_runs)
+    {
+        auto start = Clock::now();
+        run();
+        times.push_back(std::chrono::duration<double>(Clock::now() - start).count());
+        total += times.back();
+    }
+    std::sort(times.begin(), times.end());
+    double median = times[times.size() / 2];
+
+    Json::Value result;
+    result["name"] = name;
+    result["size"] = size;
+    result["runs"] = (int)times.size();
+    result["median_ms"] = median * 1e3;
+    result["min_ms"] = times.front() * 1e3;
+    result["max_ms"] = times.back() * 1e3;
+    result["ns_per_item"] = median * 1e9 / size;
+    bench_logger.info("{} ({}): {:.3f} ms median over {} runs.", name, size, median * 1e3, times.size());
+    return result;
+}
+
+int main(int argc, char* argv[])
+{
+    fs::path output = "bench.json";
+    fs::path work_directory = fs::temp_directory_path() / "raytracer_bench";
+    int max_objects = 64;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (i + 1 >= argc)
+        {
+            bench_logger.error("Argument {} expects a value.", arg);
+            return -1;
+        }
+        if (arg == "--output")
+        {
+            output = argv[++i];
+        }
+        else if (arg == "--work-dir")
+        {
+            work_directory = argv[++i];
+        }
+        else if (arg == "--max-objects")
+        {
+            max_objects = std::stoi(argv[++i]);
+        }
+        else
+        {
+            bench_logger.error("Unknown argument {}.", arg);
+            return -1;
+        }
+    }
+
+    Json::Value results(Json::arrayValue);
+
+    for (int count: {1000, 10000, 100000})
+    {
+        results.append(measure("PoseTransform::operator*", count, [count]
+        {
+            const double rotation[] = {10, 20, 30}, pivot[] = {1, 2, 3};
+            const PoseTransform step(rotation, pivot);
+            PoseTransform pose(Quaternion(1, 0, 0, 0), Quaternion(0, 0, 0, 0));
+            for (int i = 0; i < count; i++)
+            {
+                pose = pose * step;
+            }
+            sink = pose.rotation.w + pose.translation.x;
+        }));
+        results.append(measure("Quaternion::operator*", count, [count]
+        {
+            const Quaternion step(0.9, 0.1, 0.2, 0.3);
+            Quaternion value(1, 0, 0, 0);
+            for (int i = 0; i < count; i++)
+            {
+                value = value * step * (1 / 0.98);
+            }
+            sink = value.w;
+        }));
+    }
+
+    for (int cubes_per_bone: {16, 64, 256, 1024})
+    {
+        SyntheticSceneSettings settings;
+        settings.bones_per_model = 16;
+        settings.cubes_per_bone = cubes_per_bone;
+        fs::path directory = work_directory / std::format("model{}", cubes_per_bone);
+        write_synthetic_scene(directory, settings);
+        results.append(measure("Model::Model", settings.bones_per_model * cubes_per_bone, [&]
+        {
+            Model model(directory / "model0.geo.json", directory / "texture0.png");
+            sink = model.bones.size();
+        }));
+    }
+
+    for (int objects = 1; objects <= max_objects; objects *= 4)
+    {
+        SyntheticSceneSettings settings;
+        settings.objects = objects;
+        settings.bones_per_model = 16;
+        settings.cubes_per_bone = 64;
+        fs::path scene_path = write_synthetic_scene(work_directory / std::format("objects{}", objects), settings);
+        double cubes = (double)objects * settings.bones_per_model * settings.cubes_per_bone;
+
+        Scene scene(scene_path);
+        results.append(measure("Scene::pack_altas", objects, [&]
+        {
+            sink = scene.pack_altas().size();
+        }));
+        results.append(measure("Scene::build_cube_array", cubes, [&]
+        {
+            sink = scene.build_cube_array<GLfloat, GLfloat>().size();
+        }));
+        results.append(measure("Scene::build_cube_array packed", cubes, [&]
+        {
+            sink = scene.build_cube_array<GLshort, GLshort>().size();
+        }));
+
+        auto cube_array = scene.build_cube_array<GLfloat, GLfloat>();
+        results.append(measure("TextureCube::TextureCube", cubes, [&]
+        {
+            sink = TextureCube<GLfloat, GLfloat>(cube_array).size();
+        }));
+    }
+
+    std::ofstream file(output);
+    if (!file)
+    {
+        bench_logger.error("Failed to open {} for writing.", output.string());
+        return -1;
+    }
+    Json::Value report;
+    report["results"] = results;
+    file << report;
+    bench_logger.info("{} results written to {}.", results.size(), output.string());
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,90 @@
+#include "synthetic_scene.hpp"
+#include "../console/logger.hpp"
+
+#include <optional>
+#include <string>
+
+// Writes a synthetic scene for scaling tests, see `SyntheticSceneSettings`; load it with the viewer by pointing
+// it at the generated `scene.json`.
+int main(int argc, char* argv[])
+{
+    Logger logger{"Generator"};
+
+    std::optional<fs::path> output;
+    SyntheticSceneSettings settings;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (i + 1 >= argc)
+        {
+            logger.error("Argument {} expects a value.", arg);
+            return -1;
+        }
+        std::string value = argv[++i];
+        if (arg == "--output")
+        {
+            output = value;
+        }
+        else if (arg == "--objects")
+        {
+            settings.objects = std::stoi(value);
+        }
+        else if (arg == "--instanced")
+        {
+            settings.instanced_fraction = std::stod(value);
+        }
+        else if (arg == "--bones")
+        {
+            settings.bones_per_model = std::stoi(value);
+        }
+        else if (arg == "--bone-depth")
+        {
+            settings.bone_depth = std::stoi(value);
+        }
+        else if (arg == "--cubes-per-bone")
+        {
+            settings.cubes_per_bone = std::stoi(value);
+        }
+        else if (arg == "--rotated-bones")
+        {
+            settings.rotated_bones = std::stod(value);
+        }
+        else if (arg == "--rotated-cubes")
+        {
+            settings.rotated_cubes = std::stod(value);
+        }
+        else if (arg == "--min-texture")
+        {
+            settings.min_texture_size = std::stoi(value);
+        }
+        else if (arg == "--max-texture")
+        {
+            settings.max_texture_size = std::stoi(value);
+        }
+        else if (arg == "--seed")
+        {
+            settings.seed = std::stoul(value);
+        }
+        else
+        {
+            logger.error("Unknown argument {}.", arg);
+            return -1;
+        }
+    }
+    if (!output)
+    {
+        logger.error("Argument --output DIRECTORY is required.");
+        return -1;
+    }
+    if (!settings.validate())
+    {
+        return -1;
+    }
+
+    fs::path scene_path = write_synthetic_scene(*output, settings);
+    logger.info(
+        "{} objects of {} models, {} cubes in total, written to {}.",
+        settings.objects, settings.models(), (long long)settings.objects * settings.bones_per_model * settings.cubes_per_bone, scene_path.string()
+    );
+    return 0;
+}
\ No newline at end of file
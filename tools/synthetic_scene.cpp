@@ -0,0 +1,188 @@
+#include "synthetic_scene.hpp"
+#include "../console/logger.hpp"
+
+#include <array>
+#include <bit>
+#include <cmath>
+#include <fstream>
+#include <random>
+#include <vector>
+#include <stb/stb_image_write.h>
+
+static const Logger synthetic_logger{"Synthetic"};
+
+// Values in [min, max) from the raw engine output, whose sequence the standard fixes, unlike the distributions'.
+// Draws are kept out of function arguments, which may be evaluated in any order.
+static double uniform(std::mt19937& random, double min, double max)
+{
+    return min + (max - min) * (random() / 4294967296.);
+}
+
+static std::array<double, 3> uniform3(std::mt19937& random, double min, double max)
+{
+    std::array<double, 3> values;
+    for (double& value: values)
+    {
+        value = uniform(random, min, max);
+    }
+    return values;
+}
+
+static std::ofstream open_output(const fs::path& path)
+{
+    std::ofstream file(path);
+    if (!file)
+    {
+        synthetic_logger.error("Failed to open {} for writing.", path.string());
+        exit(-1);
+    }
+    return file;
+}
+
+static void write_texture(const fs::path& path, int size, std::mt19937& random)
+{
+    std::vector<unsigned char> pixels((size_t)size * size * 4);
+    for (size_t i = 0; i < pixels.size(); i += 4)
+    {
+        pixels[i] = random() & 0xff;
+        pixels[i + 1] = random() & 0xff;
+        pixels[i + 2] = random() & 0xff;
+        pixels[i + 3] = 0xff;
+    }
+    if (!stbi_write_png(path.c_str(), size, size, 4, pixels.data(), size * 4))
+    {
+        synthetic_logger.error("Failed to write texture {}.", path.string());
+        exit(-1);
+    }
+}
+
+// Bones hang off the root in chains of `bone_depth`; cubes use box UVs, which need at most 16 by 8 texels.
+static void write_model(const fs::path& path, int texture_size, const SyntheticSceneSettings& settings, std::mt19937& random)
+{
+    std::ofstream file = open_output(path);
+    file << std::format(
+        "{{\"format_version\":\"1.12.0\",\"minecraft:geometry\":[{{\"description\":{{\"identifier\":\"geometry.synthetic\","
+        "\"texture_width\":{0},\"texture_height\":{0}}},\"bones\":[\n{{\"name\":\"root\",\"pivot\":[0,0,0]}}",
+        texture_size
+    );
+    int uv_range = texture_size - 15;
+    for (int bone = 0; bone < settings.bones_per_model; bone++)
+    {
+        std::string parent = bone % settings.bone_depth? std::format("bone{}", bone - 1): "root";
+        auto pivot = uniform3(random, -16, 16);
+        file << std::format(
+            ",\n{{\"name\":\"bone{}\",\"parent\":\"{}\",\"pivot\":[{:.2f},{:.2f},{:.2f}]",
+            bone, parent, pivot[0], pivot[1] + 16, pivot[2]
+        );
+        if (uniform(random, 0, 1) < settings.rotated_bones)
+        {
+            auto rotation = uniform3(random, -45, 45);
+            file << std::format(",\"rotation\":[{:.1f},{:.1f},{:.1f}]", rotation[0], rotation[1], rotation[2]);
+        }
+        file << ",\"cubes\":[";
+        for (int cube = 0; cube < settings.cubes_per_bone; cube++)
+        {
+            auto origin = uniform3(random, -16, 16);
+            uint32_t size[3], uv[2];
+            for (auto& extent: size)
+            {
+                extent = 1 + random() % 4;
+            }
+            for (auto& coordinate: uv)
+            {
+                coordinate = random() % uv_range;
+            }
+            file << std::format(
+                "{}{{\"origin\":[{:.2f},{:.2f},{:.2f}],\"size\":[{},{},{}],\"uv\":[{},{}]",
+                cube? ",": "", origin[0], origin[1] + 16, origin[2], size[0], size[1], size[2], uv[0], uv[1]
+            );
+            if (uniform(random, 0, 1) < settings.rotated_cubes)
+            {
+                // Turn about the cube center, so the cube stays where the bone put it.
+                auto rotation = uniform3(random, -45, 45);
+                file << std::format(
+                    ",\"pivot\":[{:.2f},{:.2f},{:.2f}],\"rotation\":[{:.1f},{:.1f},{:.1f}]",
+                    origin[0] + size[0] / 2., origin[1] + 16 + size[1] / 2., origin[2] + size[2] / 2., rotation[0], rotation[1], rotation[2]
+                );
+            }
+            file << "}";
+        }
+        file << "]}";
+    }
+    file << "\n]}]}\n";
+}
+
+int SyntheticSceneSettings::models() const
+{
+    return std::max(1, (int)std::lround(objects * (1 - instanced_fraction)));
+}
+
+bool SyntheticSceneSettings::validate() const
+{
+    auto power_of_two = [](int size) { return size > 0 && (size & (size - 1)) == 0; };
+    if (objects < 1 || bones_per_model < 1 || bone_depth < 1 || cubes_per_bone < 0)
+    {
+        synthetic_logger.error("Object, bone and depth counts must be positive and cube counts not negative.");
+        return false;
+    }
+    if (instanced_fraction < 0 || instanced_fraction >= 1 || rotated_bones < 0 || rotated_bones > 1 || rotated_cubes < 0 || rotated_cubes > 1)
+    {
+        synthetic_logger.error("Fractions must lie in [0, 1], and the instanced fraction below 1.");
+        return false;
+    }
+    if (!power_of_two(min_texture_size) || !power_of_two(max_texture_size) || min_texture_size < 16 || max_texture_size > 1024 || min_texture_size > max_texture_size)
+    {
+        synthetic_logger.error("Texture sizes must be powers of two from 16 to 1024, got {} to {}.", min_texture_size, max_texture_size);
+        return false;
+    }
+    return true;
+}
+
+fs::path write_synthetic_scene(const fs::path& directory, const SyntheticSceneSettings& settings)
+{
+    if (!settings.validate())
+    {
+        exit(-1);
+    }
+    std::error_code error;
+    fs::create_directories(directory, error);
+    if (error)
+    {
+        synthetic_logger.error("Failed to create directory {}: {}.", directory.string(), error.message());
+        exit(-1);
+    }
+    const fs::path root = fs::absolute(directory);
+    std::mt19937 random(settings.seed);
+
+    int texture_sizes = std::countr_zero((unsigned)settings.max_texture_size) - std::countr_zero((unsigned)settings.min_texture_size) + 1;
+    for (int model = 0; model < settings.models(); model++)
+    {
+        int texture_size = settings.min_texture_size << (random() % texture_sizes);
+        write_model(root / std::format("model{}.geo.json", model), texture_size, settings, random);
+        write_texture(root / std::format("texture{}.png", model), texture_size, random);
+    }
+
+    fs::path scene_path = root / "scene.json";
+    std::ofstream scene = open_output(scene_path);
+    scene << std::format(
+        "{{\n\"window_size\":[1000,1000],\n\"camera\":{{\"position\":[0,35,-{}],\"orientation\":[0,0],\"fov\":1,\"d\":1,"
+        "\"keyboard_sensitivity\":0.2,\"mouse_rotation_sensitivity\":0.003,\"mouse_move_sensitivity\":0.02,"
+        "\"mouse_zoom_sensitivity\":0.05,\"ctrl_sensitivity_modifier\":0.2}},\n\"objects\":[",
+        settings.objects * 8
+    );
+    for (int object = 0; object < settings.objects; object++)
+    {
+        // The first objects own a model each, the others reuse one of them.
+        int model = object < settings.models()? object: random() % settings.models();
+        // Objects spread over an area growing with their count, so the density stays the same.
+        auto placement = uniform3(random, -64, 64);
+        double spread = std::sqrt(settings.objects);
+        scene << std::format(
+            "{}\n{{\"position\":[{:.2f},0,{:.2f}],\"rotation\":[0,{:.1f},0],\"zoom\":1,\"model\":\"{}\",\"texture\":\"{}\",\"glow\":0,\"metallic\":0}}",
+            object? ",": "", placement[0] * spread, placement[1] * spread, placement[2] * 180 / 64,
+            (root / std::format("model{}.geo.json", model)).generic_string(), (root / std::format("texture{}.png", model)).generic_string()
+        );
+    }
+    scene << "\n]\n}\n";
+    return scene_path;
+}
\ No newline at end of file
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+
+namespace fs = std::filesystem;
+
+// Shape of a generated scene. The same settings always give the same files.
+struct SyntheticSceneSettings
+{
+    int objects = 1;
+    // Fraction of the objects that reuse the model and texture of another one instead of getting their own.
+    double instanced_fraction = 0.;
+    int bones_per_model = 8;
+    // Bones form chains of up to this many below the root bone.
+    int bone_depth = 1;
+    int cubes_per_bone = 16;
+    // Fractions of the bones and cubes that get a rotation, the rest stay axis-aligned to their parent.
+    double rotated_bones = 1.;
+    double rotated_cubes = 0.;
+    // Each texture gets a power-of-two size in this range; at least 16 for the box UVs, at most the atlas width.
+    int min_texture_size = 64;
+    int max_texture_size = 64;
+    uint32_t seed = 1;
+    // Number of distinct models, and so of geometry files and textures.
+    int models() const;
+    // Log the problem and return false if the settings cannot make a loadable scene.
+    bool validate() const;
+};
+
+// Write `scene.json` with the geometry files and textures of every model into `directory`, which is created if
+// needed. Returns the scene path; the paths inside are absolute, so the scene loads from any working directory.
+fs::path write_synthetic_scene(const fs::path& directory, const SyntheticSceneSettings&);
\ No newline at end of file
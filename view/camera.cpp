@@ -1,6 +1,8 @@
 #include "camera.hpp"
 
-#include "../opengl/shader.hpp"
+#include <algorithm>
+#include <cmath>
+#include <numbers>
 
 void Camera::move_relative_yaw(float step_x, float step_y, float step_z, float modifier)
 {
@@ -36,12 +38,7 @@ void Camera::reset_fov()
     hfov = hfov_default;
 }
 
-template <>
-void Program::set(const GLchar* name, const Camera& camera)
+bool Camera::same_view(const Camera& other) const
 {
-    std::string name_str = name;
-    set((name_str + ".position").c_str(), camera.x, camera.y, camera.z);
-    set((name_str + ".orientation").c_str(), camera.yaw, camera.pitch);
-    set((name_str + ".hfov").c_str(), camera.hfov);
-    set((name_str + ".d").c_str(), camera.d);
+    return x == other.x && y == other.y && z == other.z && pitch == other.pitch && yaw == other.yaw && hfov == other.hfov && d == other.d;
 }
\ No newline at end of file
@@ -5,6 +5,7 @@ struct Camera
     float x, y, z;
     float pitch, yaw;
     float hfov, d;
+    // Distance moved per `Simulation` step while a movement key is held.
     const float keyboard_sensitivity;
     const float mouse_rotation_sensitivity;
     const float mouse_move_sensitivity;
@@ -18,4 +19,5 @@ struct Camera
     void turn_head(float, float, float);
     void zoom(float, float);
     void reset_fov();
+    bool same_view(const Camera&) const;
 };
\ No newline at end of file
@@ -0,0 +1,240 @@
+#include "culling.hpp"
+#include "../opengl/profiler.hpp"
+#include "../opengl/state.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+void CubeCuller::Bounds::extend(const Bounds& other)
+{
+    for (int i = 0; i < 3; i++)
+    {
+        min[i] = std::min(min[i], other.min[i]);
+        max[i] = std::max(max[i], other.max[i]);
+    }
+}
+
+// Same transform as shaders/vertex.glsl followed by the projection of shaders/geometry.glsl.
+CubeCuller::Projection CubeCuller::project(const Camera& camera, const Bounds& bounds)
+{
+    const float cy = std::cos(camera.yaw), sy = std::sin(camera.yaw);
+    const float cp = std::cos(camera.pitch), sp = std::sin(camera.pitch);
+    // Bit i set when a corner lies outside plane i: right, left, top, bottom, near.
+    Projection projection{0b11111, true, INFINITY, INFINITY, -INFINITY, -INFINITY, INFINITY};
+    for (int corner = 0; corner < 8; corner++)
+    {
+        const float dx = (corner & 1? bounds.max[0]: bounds.min[0]) - camera.x;
+        const float dy = (corner & 2? bounds.max[1]: bounds.min[1]) - camera.y;
+        const float dz = (corner & 4? bounds.max[2]: bounds.min[2]) - camera.z;
+        const float x = -(cy * dx - sy * dz);
+        const float z1 = sy * dx + cy * dz;
+        const float y = cp * dy - sp * z1;
+        const float z = sp * dy + cp * z1;
+        const float w = (z + camera.d) * camera.hfov;
+        const int outside = (w < x) | (w < -x) << 1 | (w < y) << 2 | (w < -y) << 3 | (z < 0) << 4;
+        projection.outside_all &= outside;
+        if (z <= 0)
+        {
+            projection.in_front = false;
+            continue;
+        }
+        projection.x0 = std::min(projection.x0, x / w);
+        projection.x1 = std::max(projection.x1, x / w);
+        projection.y0 = std::min(projection.y0, y / w);
+        projection.y1 = std::max(projection.y1, y / w);
+        projection.z = std::min(projection.z, z);
+    }
+    return projection;
+}
+
+CubeCuller::Visibility CubeCuller::test(const Camera& camera, const Bounds& bounds, bool moving) const
+{
+    const Projection current = project(camera, bounds);
+    if (current.outside_all)
+    {
+        return OUTSIDE;
+    }
+    if (!pyramid_camera)
+    {
+        return VISIBLE;
+    }
+    // Boxes crossing the near plane have no bounded footprint and are never considered occluded.
+    if (pyramid_camera->same_view(camera))
+    {
+        return current.in_front && occluded(current, 0.f)? OCCLUDED: VISIBLE;
+    }
+    if (!moving)
+    {
+        return VISIBLE;
+    }
+    // Off the pyramid's viewport nothing is known about occluders, the footprint has to lie within it.
+    const Projection previous = project(*pyramid_camera, bounds);
+    const bool within = previous.x0 >= -1.f && previous.x1 <= 1.f && previous.y0 >= -1.f && previous.y1 <= 1.f;
+    const float travelled = std::hypot(camera.x - pyramid_camera->x, camera.y - pyramid_camera->y, camera.z - pyramid_camera->z);
+    return previous.in_front && within && occluded(previous, travelled)? OCCLUDED: VISIBLE;
+}
+
+bool CubeCuller::occluded(const Projection& projection, float slack) const
+{
+    const auto [width, height] = pyramid_size[0];
+    // Footprint in texels of level 0, clamped to the viewport.
+    const float left = std::clamp((projection.x0 * 0.5f + 0.5f) * width, 0.f, width - 1.f);
+    const float right = std::clamp((projection.x1 * 0.5f + 0.5f) * width, 0.f, width - 1.f);
+    const float bottom = std::clamp((projection.y0 * 0.5f + 0.5f) * height, 0.f, height - 1.f);
+    const float top = std::clamp((projection.y1 * 0.5f + 0.5f) * height, 0.f, height - 1.f);
+    // The level where the footprint spans about two texels, so at most 3x3 of them are read.
+    const float extent = std::max(right - left, top - bottom);
+    const size_t level = std::min((size_t)std::ceil(std::log2(std::max(extent / 2.f, 1.f))), pyramid.size() - 1);
+    const auto [level_width, level_height] = pyramid_size[level];
+    const std::vector<float>& texels = pyramid[level];
+    float farthest = 0.f;
+    for (GLsizei y = (GLsizei)bottom >> level; y <= std::min((GLsizei)top >> level, level_height - 1); y++)
+    {
+        for (GLsizei x = (GLsizei)left >> level; x <= std::min((GLsizei)right >> level, level_width - 1); x++)
+        {
+            farthest = std::max(farthest, texels[(size_t)y * level_width + x]);
+        }
+    }
+    if (farthest >= 1.f)
+    {
+        return false;
+    }
+    // Window depth back to view depth: depth * 2 - 1 = (z - d) / (z + d).
+    const float ndc = farthest * 2.f - 1.f;
+    const float z = pyramid_camera->d * (1.f + ndc) / (1.f - ndc);
+    return projection.z - slack > z;
+}
+
+void CubeCuller::build_pyramid(const float* depth, GLsizei width, GLsizei height)
+{
+    ProfileScope scope{"CubeCuller::build_pyramid", false};
+    pyramid.resize(1);
+    pyramid_size.assign(1, {width, height});
+    pyramid[0].assign(depth, depth + (size_t)width * height);
+    while (width > 1 || height > 1)
+    {
+        // Odd edges fold their last texel into the previous one, so every texel keeps a parent.
+        const GLsizei parent_width = std::max(width / 2, 1), parent_height = std::max(height / 2, 1);
+        const std::vector<float>& texels = pyramid.back();
+        std::vector<float> parent((size_t)parent_width * parent_height, 0.f);
+        for (GLsizei y = 0; y < height; y++)
+        {
+            const GLsizei parent_y = std::min(y / 2, parent_height - 1);
+            for (GLsizei x = 0; x < width; x++)
+            {
+                float& texel = parent[(size_t)parent_y * parent_width + std::min(x / 2, parent_width - 1)];
+                texel = std::max(texel, texels[(size_t)y * width + x]);
+            }
+        }
+        pyramid.push_back(std::move(parent));
+        pyramid_size.emplace_back(parent_width, parent_height);
+        width = parent_width;
+        height = parent_height;
+    }
+}
+
+const DrawList& CubeCuller::cull(const Camera& camera)
+{
+    ProfileScope scope{"CubeCuller::cull", false};
+    const bool moving = culled_camera && !culled_camera->same_view(camera);
+    culled_camera.emplace(camera);
+    draw_list.first.clear();
+    draw_list.count.clear();
+    for (const Object& object: objects)
+    {
+        if (test(camera, object.bounds, moving) != VISIBLE)
+        {
+            continue;
+        }
+        for (size_t i = object.first_cluster; i < object.first_cluster + object.cluster_count; i++)
+        {
+            const Cluster& cluster = clusters[i];
+            if (test(camera, cluster.bounds, moving) != VISIBLE)
+            {
+                continue;
+            }
+            // Neighbouring clusters are contiguous in the cube array, merge them into one range.
+            if (!draw_list.first.empty() && draw_list.first.back() + draw_list.count.back() == cluster.first)
+            {
+                draw_list.count.back() += cluster.count;
+            }
+            else
+            {
+                draw_list.first.push_back(cluster.first);
+                draw_list.count.push_back(cluster.count);
+            }
+        }
+    }
+    return draw_list;
+}
+
+void CubeCuller::capture_depth(GLsizei width, GLsizei height, const Camera& camera)
+{
+    if (fences[next])
+    {
+        return;
+    }
+    if (width > max_width || height > max_height)
+    {
+        culling_logger.error("Depth read-back of {}x{} exceeds the {}x{} buffers.", width, height, max_width, max_height);
+        exit(-1);
+    }
+    ProfileScope scope{"CubeCuller::capture_depth"};
+    gl_state.bind_buffer(GL_PIXEL_PACK_BUFFER, buffers[next]);
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    glReadPixels(0, 0, width, height, GL_DEPTH_COMPONENT, GL_FLOAT, nullptr);
+    gl_state.bind_buffer(GL_PIXEL_PACK_BUFFER, 0);
+    fences[next] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    widths[next] = width;
+    heights[next] = height;
+    cameras[next].emplace(camera);
+    next = (next + 1) % ring_size;
+}
+
+void CubeCuller::poll()
+{
+    // Only the newest finished read-back matters, older ones are released unread.
+    std::optional<size_t> newest;
+    for (size_t i = 0; i < ring_size; i++)
+    {
+        size_t slot = (next + i) % ring_size;
+        if (!fences[slot])
+        {
+            continue;
+        }
+        GLenum status = glClientWaitSync(fences[slot], GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+        if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+        {
+            break;
+        }
+        glDeleteSync(fences[slot]);
+        fences[slot] = nullptr;
+        newest = slot;
+    }
+    if (!newest)
+    {
+        return;
+    }
+    size_t slot = *newest;
+    size_t size = (size_t)widths[slot] * heights[slot] * sizeof(float);
+    const auto* mapped = static_cast<const float*>(glMapNamedBufferRange(buffers[slot], 0, size, GL_MAP_READ_BIT));
+    build_pyramid(mapped, widths[slot], heights[slot]);
+    glUnmapNamedBuffer(buffers[slot]);
+    pyramid_camera.emplace(*cameras[slot]);
+}
+
+CubeCuller::~CubeCuller()
+{
+    for (GLsync fence: fences)
+    {
+        if (fence)
+        {
+            glDeleteSync(fence);
+        }
+    }
+    for (GLuint buffer: buffers)
+    {
+        gl_state.forget_buffer(buffer);
+    }
+    glDeleteBuffers(ring_size, buffers);
+}
\ No newline at end of file
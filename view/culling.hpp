@@ -0,0 +1,120 @@
+#pragma once
+
+#include "camera.hpp"
+#include "../model/scene.hpp"
+#include "../opengl/vertex.hpp"
+
+#include <optional>
+
+// Picks the cube clusters worth drawing each frame: objects and then their bones are tested against the view
+// frustum of shaders/geometry.glsl, and against a max-depth pyramid of an earlier frame for occlusion. While the
+// camera moves, bounds are reprojected into the pyramid's view and must lie behind it by the distance the camera
+// travelled since; a cluster uncovered beyond that slack appears a frame late. A still view is only tested
+// against a pyramid of itself, so the frame the render loop settles on is complete.
+class CubeCuller
+{
+    inline static const Logger culling_logger{"Culling"};
+    struct Bounds
+    {
+        float min[3]{INFINITY, INFINITY, INFINITY};
+        float max[3]{-INFINITY, -INFINITY, -INFINITY};
+        void extend(const Bounds&);
+    };
+    struct Cluster
+    {
+        GLint first;
+        GLsizei count;
+        Bounds bounds;
+    };
+    struct Object
+    {
+        size_t first_cluster = 0, cluster_count = 0;
+        Bounds bounds;
+    };
+    enum Visibility
+    {
+        OUTSIDE,
+        OCCLUDED,
+        VISIBLE
+    };
+    // Bounds as seen from a camera: clip planes all corners lie outside of, and for boxes wholly in front of
+    // it the footprint in normalized device coordinates and the nearest view depth.
+    struct Projection
+    {
+        int outside_all;
+        bool in_front;
+        float x0, y0, x1, y1, z;
+    };
+    std::vector<Object> objects;
+    std::vector<Cluster> clusters;
+    DrawList draw_list;
+
+    // Depth read-backs in flight, with the camera and viewport they were drawn with.
+    inline static constexpr size_t ring_size = 3;
+    const GLsizei max_width, max_height;
+    GLuint buffers[ring_size];
+    GLsync fences[ring_size]{};
+    GLsizei widths[ring_size]{}, heights[ring_size]{};
+    std::optional<Camera> cameras[ring_size];
+    size_t next = 0;
+    std::optional<Camera> culled_camera;
+    // Max-depth pyramid of the latest finished read-back, level 0 at its full resolution.
+    std::vector<std::vector<float>> pyramid;
+    std::vector<std::pair<GLsizei, GLsizei>> pyramid_size;
+    std::optional<Camera> pyramid_camera;
+
+    static Projection project(const Camera&, const Bounds&);
+    Visibility test(const Camera&, const Bounds&, bool moving) const;
+    // Whether the pyramid is nearer than `projection`, drawn from the pyramid's camera, by more than `slack`.
+    bool occluded(const Projection&, float slack) const;
+    void build_pyramid(const float*, GLsizei, GLsizei);
+public:
+    template <cube_data_type P, cube_data_type T>
+    CubeCuller(const CubeArray<P, T>& cubes, const std::vector<Scene::CubeCluster>& cube_clusters, GLsizei width, GLsizei height):
+        max_width(width),
+        max_height(height)
+    {
+        for (const auto& cube_cluster: cube_clusters)
+        {
+            if (objects.size() <= cube_cluster.object)
+            {
+                objects.resize(cube_cluster.object + 1);
+                objects.back().first_cluster = clusters.size();
+            }
+            Cluster& cluster = clusters.emplace_back((GLint)cube_cluster.first, (GLsizei)cube_cluster.count);
+            for (size_t i = cube_cluster.first; i < cube_cluster.first + cube_cluster.count; i++)
+            {
+                const auto& cube = cubes[i];
+                auto axes = cube.axes();
+                Bounds bounds;
+                for (int j = 0; j < 3; j++)
+                {
+                    double center = cube.origin[j], extent = 0.;
+                    for (int k = 0; k < 3; k++)
+                    {
+                        center += axes[k][j] * cube.size[k] / 2;
+                        extent += std::abs(axes[k][j]) * cube.size[k] / 2;
+                    }
+                    bounds.min[j] = center - extent;
+                    bounds.max[j] = center + extent;
+                }
+                cluster.bounds.extend(bounds);
+            }
+            objects[cube_cluster.object].cluster_count++;
+            objects[cube_cluster.object].bounds.extend(cluster.bounds);
+        }
+        glCreateBuffers(ring_size, buffers);
+        for (GLuint buffer: buffers)
+        {
+            glNamedBufferStorage(buffer, (GLsizeiptr)width * height * sizeof(float), nullptr, GL_MAP_READ_BIT);
+        }
+    }
+    // Draw list of the clusters visible from `camera`, valid until the next call.
+    const DrawList& cull(const Camera&);
+    // Queue a read-back of the bound framebuffer's depth, drawn from `camera` into a viewport of the given size,
+    // unless every buffer is still in flight.
+    void capture_depth(GLsizei, GLsizei, const Camera&);
+    // Rebuild the pyramid from the newest finished read-back, without waiting on the GPU.
+    void poll();
+    ~CubeCuller();
+};
\ No newline at end of file
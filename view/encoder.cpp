@@ -0,0 +1,135 @@
+#include "encoder.hpp"
+#include "../opengl/profiler.hpp"
+
+#include <stb/stb_image_write.h>
+
+FrameEncoder::FrameEncoder(int width, int height, double frame_rate, const fs::path& output, unsigned thread_count, const std::string& prefix):
+    width(width),
+    height(height),
+    output(output),
+    prefix(prefix),
+    y4m(output.extension() == ".y4m"),
+    max_queued(thread_count * 2)
+{
+    if (y4m)
+    {
+        stream.open(output, std::ios::binary);
+        if (!stream)
+        {
+            encoder_logger.error("Failed to open {} for writing.", output.string());
+            exit(-1);
+        }
+        stream << std::format("YUV4MPEG2 W{} H{} F{}:1000 Ip A1:1 C444 XCOLORRANGE=FULL\n", width, height, (long)std::lround(frame_rate * 1000));
+    }
+    else
+    {
+        std::error_code error;
+        fs::create_directories(output, error);
+        if (error)
+        {
+            encoder_logger.error("Failed to create directory {}: {}.", output.string(), error.message());
+            exit(-1);
+        }
+    }
+    for (unsigned i = 0; i < thread_count; i++)
+    {
+        threads.emplace_back(&FrameEncoder::work, this);
+    }
+}
+
+void FrameEncoder::submit(int frame, std::vector<unsigned char>&& pixels)
+{
+    std::unique_lock lock(mutex);
+    queue_changed.wait(lock, [this] { return queue.size() < max_queued; });
+    queue.emplace_back(frame, std::move(pixels));
+    queue_changed.notify_all();
+}
+
+void FrameEncoder::work()
+{
+    while (true)
+    {
+        std::unique_lock lock(mutex);
+        queue_changed.wait(lock, [this] { return finishing || !queue.empty(); });
+        if (queue.empty())
+        {
+            return;
+        }
+        auto [frame, pixels] = std::move(queue.front());
+        queue.pop_front();
+        queue_changed.notify_all();
+        lock.unlock();
+
+        ProfileScope scope{"FrameEncoder::encode", false};
+        if (y4m)
+        {
+            write_y4m(frame, pixels);
+        }
+        else
+        {
+            write_png(frame, pixels);
+        }
+    }
+}
+
+void FrameEncoder::write_png(int frame, const std::vector<unsigned char>& pixels) const
+{
+    fs::path file = output / std::format("{}{:05}.png", prefix, frame);
+    if (!stbi_write_png(file.c_str(), width, height, 3, pixels.data(), width * 3))
+    {
+        encoder_logger.error("Failed to write frame {}.", file.string());
+    }
+}
+
+void FrameEncoder::write_y4m(int frame, const std::vector<unsigned char>& pixels)
+{
+    // BT.601 full range, planes ordered Y, Cb, Cr and rows top first.
+    size_t plane = (size_t)width * height;
+    std::vector<unsigned char> yuv(plane * 3);
+    for (int row = 0; row < height; row++)
+    {
+        const unsigned char* source = pixels.data() + (size_t)(height - 1 - row) * width * 3;
+        for (int column = 0; column < width; column++)
+        {
+            float r = source[column * 3], g = source[column * 3 + 1], b = source[column * 3 + 2];
+            size_t index = (size_t)row * width + column;
+            yuv[index] = std::clamp(0.299f * r + 0.587f * g + 0.114f * b + 0.5f, 0.f, 255.f);
+            yuv[plane + index] = std::clamp(128.f - 0.168736f * r - 0.331264f * g + 0.5f * b + 0.5f, 0.f, 255.f);
+            yuv[plane * 2 + index] = std::clamp(128.f + 0.5f * r - 0.418688f * g - 0.081312f * b + 0.5f, 0.f, 255.f);
+        }
+    }
+
+    std::unique_lock lock(write_mutex);
+    frame_written.wait(lock, [this, frame] { return next_to_write == frame; });
+    stream << "FRAME\n";
+    stream.write(reinterpret_cast<const char*>(yuv.data()), yuv.size());
+    if (!stream)
+    {
+        encoder_logger.error("Failed to write frame {} to {}.", frame, output.string());
+    }
+    next_to_write++;
+    frame_written.notify_all();
+}
+
+void FrameEncoder::finish()
+{
+    {
+        std::lock_guard lock(mutex);
+        finishing = true;
+    }
+    queue_changed.notify_all();
+    for (auto& thread: threads)
+    {
+        thread.join();
+    }
+    threads.clear();
+    if (y4m)
+    {
+        stream.close();
+    }
+}
+
+FrameEncoder::~FrameEncoder()
+{
+    finish();
+}
\ No newline at end of file
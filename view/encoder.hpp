@@ -0,0 +1,45 @@
+#pragma once
+
+#include "../console/logger.hpp"
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+// Encodes and writes RGB8 frames (bottom row first, as read back from GL) on worker
+// threads, so the caller can go on rendering the next frame. A `.y4m` output is one
+// 4:4:4 stream written in frame order, any other path a directory of PNG files.
+class FrameEncoder
+{
+    inline static const Logger encoder_logger{"Encoder"};
+    const int width, height;
+    const fs::path output;
+    const std::string prefix;
+    const bool y4m;
+    std::ofstream stream;
+    const size_t max_queued;
+    // `mutex` guards the queue, `write_mutex` the stream and write order, so disk I/O never holds up `submit`.
+    std::mutex mutex, write_mutex;
+    std::condition_variable queue_changed, frame_written;
+    std::deque<std::pair<int, std::vector<unsigned char>>> queue;
+    int next_to_write = 0;
+    bool finishing = false;
+    std::vector<std::thread> threads;
+    void work();
+    void write_png(int, const std::vector<unsigned char>&) const;
+    void write_y4m(int, const std::vector<unsigned char>&);
+public:
+    FrameEncoder(int, int, double, const fs::path&, unsigned = std::max(2u, std::thread::hardware_concurrency()) - 1, const std::string& = "frame_");
+    // Blocks while too many frames wait for encoding, bounding memory use.
+    void submit(int, std::vector<unsigned char>&&);
+    // Wait for every submitted frame to be on disk.
+    void finish();
+    ~FrameEncoder();
+};
\ No newline at end of file
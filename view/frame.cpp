@@ -0,0 +1,44 @@
+#include "frame.hpp"
+
+#include "../opengl/profiler.hpp"
+#include "../opengl/shader.hpp"
+
+FrameBlock::FrameBlock()
+{
+    buffer.allocate(sizeof(data), GL_DYNAMIC_STORAGE_BIT);
+    buffer.bind_base(GL_UNIFORM_BUFFER, Program::frame_block_binding);
+}
+
+void FrameBlock::assign(Std140Camera& block, const Camera& camera)
+{
+    const GLfloat values[]{camera.x, camera.y, camera.z, camera.yaw, camera.pitch, camera.hfov, camera.d};
+    GLfloat* const fields[]{&block.position[0], &block.position[1], &block.position[2], &block.orientation[0], &block.orientation[1], &block.hfov, &block.d};
+    for (size_t i = 0; i < std::size(values); i++)
+    {
+        if (*fields[i] != values[i])
+        {
+            *fields[i] = values[i];
+            dirty = true;
+        }
+    }
+}
+
+void FrameBlock::set_camera(const Camera& camera)
+{
+    assign(data.camera, camera);
+}
+
+void FrameBlock::set_prev_camera(const Camera& camera)
+{
+    assign(data.prev_camera, camera);
+}
+
+void FrameBlock::upload()
+{
+    if (dirty)
+    {
+        ProfileScope scope{"FrameBlock::upload"};
+        buffer.write(data);
+        dirty = false;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,32 @@
+#pragma once
+
+#include "camera.hpp"
+#include "../opengl/buffer.hpp"
+
+#include <cstddef>
+
+// Contents of the `Frame` uniform block in shaders/camera.glsl, uploaded only when a camera changed.
+class FrameBlock
+{
+    // std140 layout of struct Camera.
+    struct alignas(16) Std140Camera
+    {
+        GLfloat position[3];
+        alignas(8) GLfloat orientation[2];
+        GLfloat hfov, d;
+    };
+    static_assert(offsetof(Std140Camera, orientation) == 16 && sizeof(Std140Camera) == 32);
+    struct
+    {
+        Std140Camera camera;
+        Std140Camera prev_camera;
+    } data{};
+    const Buffer buffer{};
+    bool dirty = true;
+    void assign(Std140Camera&, const Camera&);
+public:
+    FrameBlock();
+    void set_camera(const Camera&);
+    void set_prev_camera(const Camera&);
+    void upload();
+};
\ No newline at end of file
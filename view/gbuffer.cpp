@@ -0,0 +1,28 @@
+#include "gbuffer.hpp"
+#include "../opengl/profiler.hpp"
+
+GBuffer::GBuffer(GLsizei width, GLsizei height, const Program& raster):
+    target(width, height, {GL_RGBA32F, GL_RGBA16F, GL_RG32F, GL_R32I}, GL_DEPTH_COMPONENT32F),
+    raster(raster)
+{}
+
+void GBuffer::draw(GLsizei width, GLsizei height) const
+{
+    ProfileScope scope{"GBuffer::draw"};
+    target.bind();
+    glViewport(0, 0, width, height);
+    // Only coverage needs clearing, the other attachments are read where position.w is set.
+    const GLfloat uncovered[4]{};
+    glClearBufferfv(GL_COLOR, 0, uncovered);
+    glClear(GL_DEPTH_BUFFER_BIT);
+    raster.draw();
+    target.unbind();
+}
+
+void GBuffer::attach(Program& prog) const
+{
+    prog.set("gbuffer_position", target.color(0));
+    prog.set("gbuffer_normal", target.color(1));
+    prog.set("gbuffer_uv", target.color(2));
+    prog.set("gbuffer_index", target.color(3));
+}
\ No newline at end of file
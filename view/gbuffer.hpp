@@ -0,0 +1,19 @@
+#pragma once
+
+#include "../opengl/framebuffer.hpp"
+#include "../opengl/shader.hpp"
+
+// First hits of the hybrid ray tracer, rasterized by a program built with the GBUFFER define
+// (shaders/vertex.glsl, shaders/geometry.glsl and shaders/gbuffer/fragment.glsl); the
+// HYBRID ray-trace variant starts its paths from them and traces secondary bounces only.
+class GBuffer
+{
+    const Framebuffer target;
+    const Program& raster;
+public:
+    GBuffer(GLsizei, GLsizei, const Program&);
+    // Rasterize the lower-left `width` x `height` corner from the uploaded frame block, leaving the target unbound.
+    void draw(GLsizei, GLsizei) const;
+    // Point a HYBRID ray-trace program at the attachments.
+    void attach(Program&) const;
+};
\ No newline at end of file
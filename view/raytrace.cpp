@@ -0,0 +1,24 @@
+#include "raytrace.hpp"
+
+void RayTraceScene::attach(Program& prog) const
+{
+    prog.set_input<>();
+
+    attach_geometry(prog);
+    attach_shading(prog);
+}
+
+void RayTraceScene::attach_geometry(Program& prog) const
+{
+    prog.set("cubes", cube_texture);
+    prog.set("count", count);
+    prog.set("cube_texels", cube_texels);
+}
+
+void RayTraceScene::attach_shading(Program& prog) const
+{
+    prog.set("cubes", cube_texture);
+    prog.set("altas", altas);
+    prog.set("shading_texel", shading_texel);
+    prog.set("packed_uv", (int)packed_uv);
+}
\ No newline at end of file
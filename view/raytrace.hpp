@@ -0,0 +1,33 @@
+#pragma once
+
+#include "../model/cube.hpp"
+#include "../opengl/shader.hpp"
+
+// Cube table and atlas the ray-trace programs read the scene from; must outlive the programs' draws.
+class RayTraceScene
+{
+    const Buffer cube_buffer{};
+    const Texture cube_texture{GL_TEXTURE_BUFFER};
+    const Texture& altas;
+    const int count;
+    const int cube_texels;
+    const int shading_texel;
+    const bool packed_uv;
+public:
+    template <cube_data_type P, cube_data_type T>
+    RayTraceScene(const TextureCube<P, T>& tex_cube, const Texture& altas):
+        altas(altas),
+        count(tex_cube.size()),
+        cube_texels(TextureCube<P, T>::texels_per_cube),
+        shading_texel(TextureCube<P, T>::shading_texel),
+        packed_uv(TextureCube<P, T>::CubeType::packed_uv)
+    {
+        tex_cube.buffer_to_texture(cube_buffer, cube_texture);
+    }
+    // Point a ray-trace program, any variant of it, at the scene.
+    void attach(Program&) const;
+    // The uniforms `intersect` in shaders/raytrace/scene.glsl reads, for kernels that only trace.
+    void attach_geometry(Program&) const;
+    // The uniforms the texture and material lookups read, for kernels that only shade.
+    void attach_shading(Program&) const;
+};
\ No newline at end of file
@@ -0,0 +1,88 @@
+#include "readback.hpp"
+#include "../opengl/state.hpp"
+
+PixelReadback::PixelReadback(GLsizei width, GLsizei height):
+    width(width),
+    height(height)
+{
+    glCreateBuffers(ring_size, buffers);
+    for (GLuint buffer: buffers)
+    {
+        glNamedBufferStorage(buffer, (GLsizeiptr)width * height * 3, nullptr, GL_MAP_READ_BIT);
+    }
+}
+
+bool PixelReadback::read(const Framebuffer* framebuffer)
+{
+    if (fences[next])
+    {
+        return false;
+    }
+    gl_state.bind_buffer(GL_PIXEL_PACK_BUFFER, buffers[next]);
+    if (framebuffer)
+    {
+        framebuffer->read<GLubyte>(0, 0, 0, width, height, GL_RGB, nullptr);
+    }
+    else
+    {
+        glPixelStorei(GL_PACK_ALIGNMENT, 1);
+        glReadPixels(0, 0, width, height, GL_RGB, GL_UNSIGNED_BYTE, nullptr);
+    }
+    gl_state.bind_buffer(GL_PIXEL_PACK_BUFFER, 0);
+    fences[next] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    next = (next + 1) % ring_size;
+    return true;
+}
+
+std::optional<std::vector<unsigned char>> PixelReadback::take(bool wait)
+{
+    // The oldest read-back in flight is the first one after the slot written next.
+    for (size_t i = 0; i < ring_size; i++)
+    {
+        size_t slot = (next + i) % ring_size;
+        if (!fences[slot])
+        {
+            continue;
+        }
+        GLenum status;
+        do
+        {
+            status = glClientWaitSync(fences[slot], GL_SYNC_FLUSH_COMMANDS_BIT, wait? 1'000'000'000: 0);
+        }
+        while (wait && status == GL_TIMEOUT_EXPIRED);
+        if (status == GL_WAIT_FAILED)
+        {
+            openglLogger.error("Waiting for a pixel read-back failed.");
+            exit(-1);
+        }
+        if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+        {
+            return std::nullopt;
+        }
+        glDeleteSync(fences[slot]);
+        fences[slot] = nullptr;
+
+        size_t size = (size_t)width * height * 3;
+        const auto* mapped = static_cast<const unsigned char*>(glMapNamedBufferRange(buffers[slot], 0, size, GL_MAP_READ_BIT));
+        std::vector<unsigned char> pixels(mapped, mapped + size);
+        glUnmapNamedBuffer(buffers[slot]);
+        return pixels;
+    }
+    return std::nullopt;
+}
+
+PixelReadback::~PixelReadback()
+{
+    for (GLsync fence: fences)
+    {
+        if (fence)
+        {
+            glDeleteSync(fence);
+        }
+    }
+    for (GLuint buffer: buffers)
+    {
+        gl_state.forget_buffer(buffer);
+    }
+    glDeleteBuffers(ring_size, buffers);
+}
\ No newline at end of file
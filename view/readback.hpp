@@ -0,0 +1,28 @@
+#pragma once
+
+#include "../opengl/framebuffer.hpp"
+
+#include <optional>
+#include <vector>
+
+// Reads RGB8 frames back into pixel buffer objects guarded by fences and maps each only once the GPU is
+// done with it, a frame or two later, so the caller goes on rendering instead of waiting on glReadPixels.
+class PixelReadback
+{
+public:
+    inline static constexpr size_t ring_size = 3;
+private:
+    const GLsizei width, height;
+    GLuint buffers[ring_size];
+    GLsync fences[ring_size]{};
+    size_t next = 0;
+public:
+    PixelReadback(GLsizei, GLsizei);
+    // Queue a read-back of color attachment 0 of `framebuffer`, or of the current read framebuffer without
+    // one; false when every buffer is still in flight.
+    bool read(const Framebuffer* = nullptr);
+    // Pixels of the oldest queued read-back once the GPU finished it, waiting for it if `wait`; nothing when
+    // none is queued, or it is not done yet and `wait` is false.
+    std::optional<std::vector<unsigned char>> take(bool wait);
+    ~PixelReadback();
+};
\ No newline at end of file
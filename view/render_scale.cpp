@@ -0,0 +1,25 @@
+#include "render_scale.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+void RenderScale::update(float frame_time)
+{
+    if (target_frame_time <= 0 || frame_time <= 0)
+    {
+        return;
+    }
+    float ratio = target_frame_time / frame_time;
+    if (std::abs(1 - ratio) < tolerance)
+    {
+        return;
+    }
+    // Tracing cost grows with the pixel count, that is with the square of the scale.
+    float desired = scale * std::sqrt(ratio);
+    scale = std::clamp(scale + (desired - scale) * smoothing, min_scale, max_scale);
+}
+
+int RenderScale::scaled(int size) const
+{
+    return std::max(1, (int)std::lround(size * scale));
+}
\ No newline at end of file
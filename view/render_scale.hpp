@@ -0,0 +1,14 @@
+#pragma once
+
+// Fraction of the window resolution the frame is traced at, steered towards a GPU frame-time budget.
+struct RenderScale
+{
+    const float target_frame_time;
+    const float min_scale;
+    float scale = 1.f;
+    inline static const float max_scale = 1.f;
+    inline static const float smoothing = 0.3f;
+    inline static const float tolerance = 0.1f;
+    void update(float);
+    int scaled(int) const;
+};
\ No newline at end of file
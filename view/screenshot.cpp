@@ -0,0 +1,29 @@
+#include "screenshot.hpp"
+#include "../opengl/profiler.hpp"
+
+#include <chrono>
+
+ScreenshotCapture::ScreenshotCapture(GLsizei width, GLsizei height, const fs::path& save_path):
+    readback(width, height),
+    encoder(width, height, 0, save_path, 1, std::format("screenshot_{:%Y%m%d_%H%M%S}_", std::chrono::floor<std::chrono::seconds>(std::chrono::system_clock::now())))
+{}
+
+bool ScreenshotCapture::capture()
+{
+    ProfileScope scope{"ScreenshotCapture::capture"};
+    if (!readback.read())
+    {
+        screenshot_logger.info("All {} read-back buffers are busy, screenshot skipped.", PixelReadback::ring_size);
+        return false;
+    }
+    return true;
+}
+
+void ScreenshotCapture::poll()
+{
+    // Oldest capture first, so files are numbered in capture order.
+    while (auto pixels = readback.take(false))
+    {
+        encoder.submit(taken++, std::move(*pixels));
+    }
+}
\ No newline at end of file
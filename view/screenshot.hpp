@@ -0,0 +1,19 @@
+#pragma once
+
+#include "encoder.hpp"
+#include "readback.hpp"
+
+// Reads the window back through a `PixelReadback` ring; PNG encoding runs on FrameEncoder threads.
+class ScreenshotCapture
+{
+    inline static const Logger screenshot_logger{"Screenshot"};
+    PixelReadback readback;
+    int taken = 0;
+    FrameEncoder encoder;
+public:
+    ScreenshotCapture(GLsizei, GLsizei, const fs::path&);
+    // Queue a read-back of the current read framebuffer, false when every buffer is still in flight.
+    bool capture();
+    // Hand finished read-backs over to the encoder without waiting on the GPU.
+    void poll();
+};
\ No newline at end of file
@@ -1,7 +1,11 @@
 #include "sdl.hpp"
+#include "../opengl/profiler.hpp"
 
 #include <SDL2/SDL_opengl.h>
 
+#include <chrono>
+#include <thread>
+
 #define STB_IMAGE_WRITE_IMPLEMENTATION
 #include <stb/stb_image_write.h>
 
@@ -9,7 +13,9 @@ SDL_Context::SDL_Context(
     int window_width,
     int window_height,
     const std::string& window_name,
-    Camera&& camera
+    Camera&& camera,
+    RenderScale&& render_scale,
+    const fs::path& screenshot_path
 ):
     window_width(window_width),
     window_height(window_height),
@@ -22,7 +28,10 @@ SDL_Context::SDL_Context(
         SDL_WINDOW_OPENGL
     )),
     gl_context(SDL_GL_CreateContext(window)),
-    camera(camera)
+    camera(camera),
+    render_scale(render_scale),
+    render_target(window_width, window_height, {GL_RGBA8}, GL_DEPTH_COMPONENT24),
+    screenshots(window_width, window_height, screenshot_path)
 {
     if (window == NULL)
     {
@@ -48,92 +57,146 @@ void SDL_Context::swap() const
     SDL_GL_SwapWindow(window);
 }
 
-void SDL_Context::render_loop(Program& prog, void (*call_back)())
+void SDL_Context::render_loop(Program& quality, const RenderOptions& options)
 {
-    bool running = true;
-    const Uint8* key_states = SDL_GetKeyboardState(nullptr);
-    while (running)
+    // Events are handled on the thread that created the window, so it runs the simulation and the context
+    // moves to a render thread; a slow frame then no longer holds up input.
+    Simulation simulation(camera, (bool)options.animate);
+    SDL_GL_MakeCurrent(window, nullptr);
+    std::thread renderer([&]
     {
-        SDL_Event event;
-        struct
+        SDL_GL_MakeCurrent(window, gl_context);
+        draw_frames(simulation, quality, options);
+        SDL_GL_MakeCurrent(window, nullptr);
+    });
+    while (simulation.update(idle_wait_ms))
+    {
+    }
+    renderer.join();
+    SDL_GL_MakeCurrent(window, gl_context);
+}
+
+void SDL_Context::draw_frames(Simulation& simulation, Program& quality, const RenderOptions& options)
+{
+    std::optional<SimulationState> state;
+    unsigned long seen_state = 0;
+    int seen_captures = 0, seen_redraws = 0;
+    std::optional<Camera> last_view;
+    std::optional<double> posed_time;
+    // Frames drawn since the view or the scene last changed. Accumulating paths refine a still view up to
+    // `refine_frames` frames, the others are done after one; then the thread sleeps until the simulation
+    // changes something.
+    int still_frames = 0;
+    const int settle_frames = options.temporal || options.wavefront? refine_frames: 1;
+    while (true)
+    {
+        bool idle = state && !state->burst_capture && settle_frames > 0 && still_frames >= settle_frames;
+        bool fresh = simulation.take(state, seen_state, std::chrono::milliseconds(idle? idle_wait_ms: 0));
+        if (!state->running)
         {
-            float xrel, yrel;
-            float wheel;
-            bool left, right;
-            bool have_motion, have_wheel;
-        } mouse_motion;
-        while (SDL_PollEvent(&event))
+            break;
+        }
+        if (idle && !fresh)
+        {
+            screenshots.poll();
+            continue;
+        }
+        bool capture = state->captures != seen_captures;
+        bool redraw = state->redraws != seen_redraws;
+        seen_captures = state->captures;
+        seen_redraws = state->redraws;
+        const Camera& view = state->camera;
+
+        bool view_changed = !last_view || !last_view->same_view(view);
+        bool scene_changed = options.animate && posed_time != state->scene_time;
+        if (idle && !view_changed && !scene_changed && !capture && !redraw)
+        {
+            continue;
+        }
+        if (view_changed || scene_changed)
+        {
+            still_frames = 0;
+        }
+        else if (++still_frames == settle_frames)
+        {
+            sdl_logger.info("View refined over {} frames, idling until it changes.", settle_frames);
+        }
+
+        ProfileScope frame_scope{"frame"};
+        Program& prog = options.preview && view_changed && last_view? *options.preview: quality;
+        last_view.emplace(view);
+        if (scene_changed)
+        {
+            options.animate(state->scene_time);
+            posed_time = state->scene_time;
+        }
+
+        int render_width = render_scale.scaled(window_width);
+        int render_height = render_scale.scaled(window_height);
+
+        // The G-buffer pass is timed with the frame, so hybrid and full tracing compare fairly.
+        frame_timer.begin();
+        if (options.gbuffer)
+        {
+            frame_block.set_camera(view);
+            frame_block.upload();
+            options.gbuffer->draw(render_width, render_height);
+        }
+
+        const Framebuffer* output;
+        if (options.wavefront)
+        {
+            frame_block.set_camera(view);
+            frame_block.upload();
+            output = &options.wavefront->trace(view, render_width, render_height);
+            frame_timer.end();
+        }
+        else
         {
-            if (event.type == SDL_KEYDOWN)
+            if (options.temporal)
             {
-                if (event.key.keysym.sym == SDLK_ESCAPE)
-                {
-                    running = false;
-                }
-                else if (event.key.keysym.sym == SDLK_F2)
-                {
-                    unsigned char* img = new unsigned char[window_width * window_height * 3];
-                    glReadPixels(0, 0, window_width, window_height, GL_RGB, GL_UNSIGNED_BYTE, img);
-                    stbi_write_png("../.cache/screenshot.png", window_width, window_height, 3, img, 0);
-                    delete[] img;
-                }
-                else if (event.key.keysym.sym == SDLK_r)
-                {
-                    camera.reset_fov();
-                }
+                options.temporal->begin(prog, frame_block, view);
             }
-            else if (event.type == SDL_MOUSEMOTION)
+            else
             {
-                mouse_motion.xrel = event.motion.xrel;
-                mouse_motion.yrel = event.motion.yrel;
-                mouse_motion.left = event.motion.state & SDL_BUTTON(SDL_BUTTON_LEFT);
-                mouse_motion.right = event.motion.state & SDL_BUTTON(SDL_BUTTON_RIGHT);
-                mouse_motion.have_motion = true;
+                render_target.bind();
             }
-            else if (event.type == SDL_MOUSEWHEEL)
+            glViewport(0, 0, render_width, render_height);
+            glClearColor(0.5f, 0.5f, 0.5f, 0.f);
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+            frame_block.set_camera(view);
+            frame_block.upload();
+            if (options.culler)
             {
-                mouse_motion.wheel = event.wheel.preciseY;
-                mouse_motion.have_wheel = true;
+                options.culler->poll();
             }
-            else if (event.type == SDL_QUIT)
+            prog.draw(options.culler? &options.culler->cull(view): nullptr);
+            frame_timer.end();
+            if (options.culler)
             {
-                running = false;
+                options.culler->capture_depth(render_width, render_height, view);
             }
-        }
-
-        float modifier = key_states[SDL_SCANCODE_LCTRL]? camera.ctrl_sensitivity_modifier: 1;
 
-        if (mouse_motion.have_motion)
+            output = options.temporal? &options.temporal->end(view, 0, 0, render_width, render_height): &render_target;
+        }
+        output->unbind();
+        glViewport(0, 0, window_width, window_height);
         {
-            if (mouse_motion.left && !mouse_motion.right)
-            {
-                camera.turn_head(-mouse_motion.xrel, -mouse_motion.yrel, camera.mouse_rotation_sensitivity * modifier);
-            }
-            else if (mouse_motion.right && !mouse_motion.left)
-            {
-                camera.move_relative(mouse_motion.xrel, mouse_motion.yrel, 0, camera.mouse_move_sensitivity * modifier);
-            }
-            mouse_motion.have_motion = false;
+            ProfileScope scope{"Framebuffer::blit"};
+            output->blit(render_width, render_height, window_width, window_height);
         }
 
-        if (mouse_motion.have_wheel)
+        if (capture || state->burst_capture)
         {
-            camera.zoom(mouse_motion.wheel, camera.mouse_zoom_sensitivity * modifier);
-            mouse_motion.have_wheel = false;
+            screenshots.capture();
         }
+        screenshots.poll();
 
-        camera.move_relative_yaw(
-            key_states[SDL_SCANCODE_A] - key_states[SDL_SCANCODE_D],
-            key_states[SDL_SCANCODE_SPACE] - key_states[SDL_SCANCODE_LSHIFT],
-            key_states[SDL_SCANCODE_W] - key_states[SDL_SCANCODE_S],
-            camera.keyboard_sensitivity * modifier
-        );
-
-        glClearColor(0.5f, 0.5f, 0.5f, 0.f);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-        prog.set("camera", camera);
-        prog.draw();
+        if (auto frame_time = frame_timer.poll())
+        {
+            render_scale.update(*frame_time);
+        }
 
         // unsigned char* img = new unsigned char[window_width * window_height * 3];
         // glReadPixels(0, 0, window_width, window_height, window_height, GL_UNSIGNED_BYTE, img);
@@ -141,13 +204,114 @@ void SDL_Context::render_loop(Program& prog, void (*call_back)())
         // delete[] img;
         // return;
 
-        if (call_back)
+        swap();
+        profiler.frame();
+    }
+}
+
+void SDL_Context::benchmark(Program& prog, TemporalAccumulator& accumulator, WavefrontTracer& wavefront, int frames)
+{
+    auto measure = [&](auto&& frame)
+    {
+        glFinish();
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < frames; i++)
         {
-            call_back();
+            frame();
+            profiler.frame();
         }
+        glFinish();
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    };
+
+    // History is dropped before every fragment frame, so neither side pays for reprojection. The seed still
+    // advances, as it does for the wavefront tracer.
+    int fragment_frame = 0;
+    double fragment_time = measure([&]
+    {
+        accumulator.reset(fragment_frame++);
+        accumulator.begin(prog, frame_block, camera);
+        glViewport(0, 0, window_width, window_height);
+        frame_block.set_camera(camera);
+        frame_block.upload();
+        prog.draw();
+        accumulator.end(camera, 0, 0, window_width, window_height).unbind();
+    });
+    double wavefront_time = measure([&]
+    {
+        frame_block.set_camera(camera);
+        frame_block.upload();
+        wavefront.trace(camera, window_width, window_height);
+    });
+
+    // Only the wavefront tracer counts its rays. The fragment shader ends and seeds paths differently, so
+    // the count says nothing about the rays it cast and it is compared by frame time alone.
+    double rays = (double)wavefront.ray_casts() * frames;
+    sdl_logger.info("Fragment shader: {:.3f} ms per frame.", fragment_time * 1e3 / frames);
+    sdl_logger.info("Wavefront: {:.3f} ms per frame, {:.1f} Mrays/s, {:.2f}x the fragment shader's frame rate.", wavefront_time * 1e3 / frames, rays / wavefront_time * 1e-6, fragment_time / wavefront_time);
+}
+
+void SDL_Context::render_sequence(Program& prog, TemporalAccumulator& accumulator, const CameraPath& path, FrameEncoder& encoder)
+{
+    int frame_count = path.frame_count();
+    // Frames are mapped once the GPU is done with them, frame N while N + 1 renders.
+    PixelReadback readback(window_width, window_height);
+    int submitted = 0;
+    for (int frame = 0; frame < frame_count; frame++)
+    {
+        CameraPath::Keyframe keyframe = path.at(path.keyframes.front().time + frame / path.frame_rate);
+        camera.x = keyframe.position[0];
+        camera.y = keyframe.position[1];
+        camera.z = keyframe.position[2];
+        camera.yaw = keyframe.orientation[0];
+        camera.pitch = keyframe.orientation[1];
+        camera.hfov = keyframe.fov;
 
+        accumulator.reset();
+        const Framebuffer* output = nullptr;
+        for (int pass = 0; pass < path.samples; pass++)
+        {
+            accumulator.begin(prog, frame_block, camera);
+            glViewport(0, 0, window_width, window_height);
+            frame_block.set_camera(camera);
+            frame_block.upload();
+            prog.draw();
+            output = &accumulator.end(camera, 0, 0, window_width, window_height);
+        }
+
+        {
+            ProfileScope scope{"PixelReadback::read"};
+            // With every buffer in flight the oldest frame is waited for, the GPU runs at most that far ahead.
+            while (!readback.read(output))
+            {
+                encoder.submit(submitted++, *readback.take(true));
+            }
+        }
+        output->unbind();
+        output->blit(window_width, window_height, window_width, window_height);
         swap();
+        profiler.frame();
+        while (auto pixels = readback.take(false))
+        {
+            encoder.submit(submitted++, std::move(*pixels));
+        }
+        sdl_logger.info("Frame {}/{} rendered.", frame + 1, frame_count);
+
+        SDL_Event event;
+        while (SDL_PollEvent(&event))
+        {
+            if (event.type == SDL_QUIT || (event.type == SDL_KEYDOWN && event.key.keysym.sym == SDLK_ESCAPE))
+            {
+                sdl_logger.info("Sequence interrupted after {} frames.", frame + 1);
+                frame_count = frame + 1;
+            }
+        }
+    }
+    while (auto pixels = readback.take(true))
+    {
+        encoder.submit(submitted++, std::move(*pixels));
     }
+    encoder.finish();
 }
 
 SDL_Context::~SDL_Context()
@@ -1,11 +1,41 @@
 #pragma once
 
 #include "camera.hpp"
+#include "culling.hpp"
+#include "encoder.hpp"
+#include "gbuffer.hpp"
+#include "readback.hpp"
+#include "render_scale.hpp"
+#include "screenshot.hpp"
+#include "simulation.hpp"
+#include "temporal.hpp"
+#include "wavefront.hpp"
 #include "../console/logger.hpp"
+#include "../model/camera_path.hpp"
+#include "../opengl/framebuffer.hpp"
+#include "../opengl/query.hpp"
 #include "../opengl/shader.hpp"
 
 #include <SDL2/SDL.h>
 
+// What `SDL_Context::render_loop` draws besides its program; every member is optional.
+struct RenderOptions
+{
+    // Poses an animated scene at a scene time on the render thread. The simulation then steps that time at
+    // its fixed rate, and each new step is posed and drawn.
+    std::function<void(double)> animate;
+    // Accumulates samples of a still view, refining it for `refine_frames` frames.
+    TemporalAccumulator* temporal = nullptr;
+    // Drawn instead of the program while the camera moves.
+    Program* preview = nullptr;
+    // Limits the draw to the cube clusters it finds visible.
+    CubeCuller* culler = nullptr;
+    // Rasterized before each frame for HYBRID ray-trace programs.
+    const GBuffer* gbuffer = nullptr;
+    // Traces every frame instead of the programs.
+    WavefrontTracer* wavefront = nullptr;
+};
+
 class SDL_Context
 {
     inline static const Logger sdl_logger{"SDL"};
@@ -15,8 +45,27 @@ class SDL_Context
     SDL_GLContext const gl_context;
 public:
     Camera camera;
-    SDL_Context(int, int, const std::string&, Camera&&);
+    RenderScale render_scale;
+    // Frames a still view keeps refining in `render_loop` when it accumulates samples, 0 refines forever.
+    int refine_frames = 0;
+    // How long an idle `render_loop` blocks for events, or for a new view, before polling screenshots again.
+    inline static const Uint32 idle_wait_ms = 100;
+private:
+    const Framebuffer render_target;
+    GpuTimer frame_timer;
+    ScreenshotCapture screenshots;
+    FrameBlock frame_block;
+    // The render thread of `render_loop`, drawing the states the simulation publishes until it stops.
+    void draw_frames(Simulation&, Program&, const RenderOptions&);
+public:
+    SDL_Context(int, int, const std::string&, Camera&&, RenderScale&&, const fs::path&);
     void swap() const;
-    void render_loop(Program&, void (*)());
+    // Camera input is simulated at a fixed rate on the calling thread while frames are drawn on another.
+    void render_loop(Program&, const RenderOptions& = {});
+    // Trace `frames` frames of the current view with the fragment-shader program and then with the wavefront
+    // tracer, neither reprojecting history, and log the frame time of both and the wavefront ray throughput.
+    void benchmark(Program&, TemporalAccumulator&, WavefrontTracer&, int frames);
+    // Trace every frame of the path offline, handing finished frames to the encoder while the next one renders.
+    void render_sequence(Program&, TemporalAccumulator&, const CameraPath&, FrameEncoder&);
     ~SDL_Context();
 };
\ No newline at end of file
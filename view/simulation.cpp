@@ -0,0 +1,143 @@
+#include "simulation.hpp"
+
+#include <algorithm>
+
+Simulation::Simulation(Camera& camera, bool animated):
+    camera(camera),
+    animated(animated),
+    key_states(SDL_GetKeyboardState(nullptr)),
+    next_step(Clock::now())
+{
+    publish();
+}
+
+void Simulation::handle(const SDL_Event& event)
+{
+    float modifier = key_states[SDL_SCANCODE_LCTRL]? camera.ctrl_sensitivity_modifier: 1;
+    if (event.type == SDL_KEYDOWN)
+    {
+        if (event.key.keysym.sym == SDLK_ESCAPE)
+        {
+            running = false;
+        }
+        else if (event.key.keysym.sym == SDLK_F2)
+        {
+            captures++;
+        }
+        else if (event.key.keysym.sym == SDLK_F3 && !event.key.repeat)
+        {
+            burst_capture = !burst_capture;
+            simulation_logger.info("Burst capture {}.", burst_capture? "started": "stopped");
+        }
+        else if (event.key.keysym.sym == SDLK_r)
+        {
+            camera.reset_fov();
+        }
+    }
+    else if (event.type == SDL_MOUSEMOTION)
+    {
+        bool left = event.motion.state & SDL_BUTTON(SDL_BUTTON_LEFT);
+        bool right = event.motion.state & SDL_BUTTON(SDL_BUTTON_RIGHT);
+        if (left && !right)
+        {
+            camera.turn_head(-event.motion.xrel, -event.motion.yrel, camera.mouse_rotation_sensitivity * modifier);
+        }
+        else if (right && !left)
+        {
+            camera.move_relative(event.motion.xrel, event.motion.yrel, 0, camera.mouse_move_sensitivity * modifier);
+        }
+    }
+    else if (event.type == SDL_MOUSEWHEEL)
+    {
+        camera.zoom(event.wheel.preciseY, camera.mouse_zoom_sensitivity * modifier);
+    }
+    else if (event.type == SDL_WINDOWEVENT)
+    {
+        // The window may have been covered, the back buffer is drawn again.
+        redraws++;
+    }
+    else if (event.type == SDL_QUIT)
+    {
+        running = false;
+    }
+}
+
+bool Simulation::update(Uint32 idle_wait_ms)
+{
+    const auto step = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1. / step_rate));
+
+    Uint32 timeout = idle_wait_ms;
+    if (moving || animated)
+    {
+        auto until_step = std::chrono::ceil<std::chrono::milliseconds>(next_step - Clock::now()).count();
+        timeout = (Uint32)std::max<long long>(until_step, 0);
+    }
+    SDL_Event event;
+    bool pending = timeout > 0? SDL_WaitEventTimeout(&event, timeout): SDL_PollEvent(&event);
+    bool changed = pending;
+    for (; pending; pending = SDL_PollEvent(&event))
+    {
+        handle(event);
+    }
+
+    int step_x = key_states[SDL_SCANCODE_A] - key_states[SDL_SCANCODE_D];
+    int step_y = key_states[SDL_SCANCODE_SPACE] - key_states[SDL_SCANCODE_LSHIFT];
+    int step_z = key_states[SDL_SCANCODE_W] - key_states[SDL_SCANCODE_S];
+    auto now = Clock::now();
+    if (!moving && !animated)
+    {
+        // Time spent waiting with nothing to step is not caught up on.
+        next_step = now;
+    }
+    moving = step_x || step_y || step_z;
+    if (moving || animated)
+    {
+        float modifier = key_states[SDL_SCANCODE_LCTRL]? camera.ctrl_sensitivity_modifier: 1;
+        int steps = 0;
+        for (; next_step <= now && steps < max_catch_up_steps; steps++)
+        {
+            if (moving)
+            {
+                camera.move_relative_yaw(step_x, step_y, step_z, camera.keyboard_sensitivity * modifier);
+            }
+            if (animated)
+            {
+                scene_time += 1. / step_rate;
+            }
+            next_step += step;
+        }
+        if (next_step <= now)
+        {
+            simulation_logger.trace("Dropped {} ms of simulation steps after a stall.", std::chrono::duration_cast<std::chrono::milliseconds>(now - next_step).count());
+            next_step = now + step;
+        }
+        changed = changed || steps > 0;
+    }
+
+    if (changed)
+    {
+        publish();
+    }
+    return running;
+}
+
+void Simulation::publish()
+{
+    std::lock_guard lock(mutex);
+    published.emplace(camera, scene_time, captures, redraws, burst_capture, running);
+    version++;
+    published_changed.notify_all();
+}
+
+bool Simulation::take(std::optional<SimulationState>& state, unsigned long& seen, std::chrono::milliseconds wait)
+{
+    std::unique_lock lock(mutex);
+    published_changed.wait_for(lock, wait, [&] { return version != seen; });
+    if (version == seen)
+    {
+        return false;
+    }
+    state.emplace(*published);
+    seen = version;
+    return true;
+}
\ No newline at end of file
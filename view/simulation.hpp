@@ -0,0 +1,61 @@
+#pragma once
+
+#include "camera.hpp"
+#include "../console/logger.hpp"
+
+#include <SDL2/SDL.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <optional>
+
+// What the simulation hands the render thread each step. Captures and redraws count requests, the render
+// thread acts on the ones it has not seen yet. `scene_time` is the seconds an animated scene has run.
+struct SimulationState
+{
+    Camera camera;
+    double scene_time;
+    int captures;
+    int redraws;
+    bool burst_capture;
+    bool running;
+};
+
+// Samples input and moves the camera in fixed steps on the thread that owns the window, independent of how
+// long frames take; an animated scene advances its time with the same steps. Each change is published as a
+// whole `SimulationState`: the simulation edits the camera while the render thread draws from its own copy
+// of the last published one.
+class Simulation
+{
+    using Clock = std::chrono::steady_clock;
+    inline static const Logger simulation_logger{"Simulation"};
+    Camera& camera;
+    const bool animated;
+    double scene_time = 0;
+    const Uint8* const key_states;
+    int captures = 0;
+    int redraws = 0;
+    bool burst_capture = false;
+    bool running = true;
+    Clock::time_point next_step;
+    bool moving = false;
+    std::mutex mutex;
+    std::condition_variable published_changed;
+    std::optional<SimulationState> published;
+    unsigned long version = 0;
+    void handle(const SDL_Event&);
+    void publish();
+public:
+    // Steps per second, the keyboard sensitivity is a distance per step.
+    inline static const int step_rate = 60;
+    // Steps taken at most to catch up after a stall, the rest of the time is dropped.
+    inline static const int max_catch_up_steps = 10;
+    explicit Simulation(Camera&, bool animated = false);
+    // Handle the pending events and step the camera and scene time up to now. Waits for the next step while
+    // a movement key is held or the scene is animated, otherwise for up to `idle_wait_ms` or the next event.
+    // False once the user quits.
+    bool update(Uint32 idle_wait_ms);
+    // Copy the newest published state into `state` if it is newer than `seen`, waiting up to `wait` for one.
+    bool take(std::optional<SimulationState>& state, unsigned long& seen, std::chrono::milliseconds wait);
+};
\ No newline at end of file
@@ -0,0 +1,45 @@
+#include "temporal.hpp"
+
+TemporalAccumulator::TemporalAccumulator(GLsizei width, GLsizei height):
+    history{
+        Framebuffer(width, height, {GL_RGBA32F, GL_R32F}),
+        Framebuffer(width, height, {GL_RGBA32F, GL_R32F})
+    }
+{}
+
+void TemporalAccumulator::reset(int first_frame)
+{
+    previous.reset();
+    frame_index = first_frame;
+}
+
+void TemporalAccumulator::begin(Program& prog, FrameBlock& frame, const Camera& camera) const
+{
+    const Framebuffer& last = history[current ^ 1];
+    float max_history = 0.f;
+    if (previous)
+    {
+        max_history = previous->same_view(camera)? still_history: moving_history;
+    }
+    prog.set("history_radiance", last.color(0));
+    prog.set("history_depth", last.color(1));
+    prog.set("history_offset", (GLfloat)history_x, (GLfloat)history_y);
+    prog.set("history_size", (GLfloat)history_width, (GLfloat)history_height);
+    prog.set("max_history", max_history);
+    prog.set("frame_index", frame_index);
+    frame.set_prev_camera(previous.value_or(camera));
+    history[current].bind();
+}
+
+const Framebuffer& TemporalAccumulator::end(const Camera& camera, GLint x, GLint y, GLsizei width, GLsizei height)
+{
+    const Framebuffer& written = history[current];
+    previous.emplace(camera);
+    history_x = x;
+    history_y = y;
+    history_width = width;
+    history_height = height;
+    current ^= 1;
+    frame_index++;
+    return written;
+}
\ No newline at end of file
@@ -0,0 +1,30 @@
+#pragma once
+
+#include "camera.hpp"
+#include "frame.hpp"
+#include "../opengl/framebuffer.hpp"
+#include "../opengl/shader.hpp"
+
+#include <optional>
+
+// Ping-pong history for the ray tracer: each frame reprojects the previous frame's
+// radiance and first-hit depth into the current view and blends new samples in.
+class TemporalAccumulator
+{
+    const Framebuffer history[2];
+    size_t current = 0;
+    GLint history_x = 0, history_y = 0;
+    GLsizei history_width = 0, history_height = 0;
+    std::optional<Camera> previous;
+    int frame_index = 0;
+public:
+    // Frames of history a pixel may keep while the camera moves, bounding ghosting.
+    inline static const float moving_history = 8.f;
+    inline static const float still_history = 4096.f;
+    TemporalAccumulator(GLsizei, GLsizei);
+    // Drop the history and continue the sampling sequence at `first_frame`.
+    void reset(int first_frame = 0);
+    void begin(Program&, FrameBlock&, const Camera&) const;
+    // Takes the viewport the frame was drawn with, which may start outside the target when rendering a tile.
+    const Framebuffer& end(const Camera&, GLint, GLint, GLsizei, GLsizei);
+};
\ No newline at end of file
@@ -0,0 +1,116 @@
+#include "wavefront.hpp"
+#include "../opengl/profiler.hpp"
+
+#include <cstddef>
+
+static ShaderDefines kernel_defines(ShaderDefines defines, GLuint group_size)
+{
+    defines["GROUP_SIZE"] = std::to_string(group_size);
+    return defines;
+}
+
+static int define_or(const ShaderDefines& defines, const std::string& name, int fallback)
+{
+    auto iter = defines.find(name);
+    return iter == defines.end()? fallback: std::stoi(iter->second);
+}
+
+// Every kernel reads what the previous one wrote, through storage buffers, images and the indirect arguments.
+static void kernel_barrier()
+{
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT | GL_SHADER_IMAGE_ACCESS_BARRIER_BIT | GL_COMMAND_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT);
+}
+
+WavefrontTracer::WavefrontTracer(const RayTraceScene& scene, GLsizei width, GLsizei height, const ShaderDefines& defines):
+    generate("../shaders/wavefront/generate.glsl", kernel_defines(defines, group_size)),
+    intersect("../shaders/wavefront/intersect.glsl", kernel_defines(defines, group_size)),
+    shade("../shaders/wavefront/shade.glsl", kernel_defines(defines, group_size)),
+    compact("../shaders/wavefront/compact.glsl", kernel_defines(defines, group_size)),
+    prepare("../shaders/wavefront/prepare.glsl", kernel_defines(defines, group_size)),
+    resolve("../shaders/wavefront/resolve.glsl", kernel_defines(defines, group_size)),
+    output(width, height, {GL_RGBA8}),
+    max_width(width),
+    max_height(height),
+    samples(define_or(defines, "SAMPLE_COUNT", default_samples)),
+    bounces(define_or(defines, "MAX_BOUNCES", default_bounces))
+{
+    for (const Buffer& queue: queues)
+    {
+        queue.allocate(path_size * width * height);
+    }
+    counters.allocate(sizeof(Counters), GL_DYNAMIC_STORAGE_BIT);
+    radiance.allocate(width, height, GL_RGBA32F);
+    scene.attach_geometry(intersect);
+    scene.attach_shading(shade);
+}
+
+const Framebuffer& WavefrontTracer::trace(const Camera& camera, GLsizei width, GLsizei height)
+{
+    ProfileScope scope{"WavefrontTracer::trace"};
+    width = std::min(width, max_width);
+    height = std::min(height, max_height);
+    if (!accumulated_view || !accumulated_view->same_view(camera) || width != accumulated_width || height != accumulated_height)
+    {
+        const GLfloat zero[4]{};
+        radiance.clear(GL_RGBA, zero);
+        accumulated_view.emplace(camera);
+        accumulated_width = width;
+        accumulated_height = height;
+    }
+    for (Program* prog: {&generate, &shade, &resolve})
+    {
+        prog->set("size", (GLint)width, (GLint)height);
+    }
+    radiance.bind_image(0, GL_READ_WRITE, GL_RGBA32F);
+    output.color(0).bind_image(1, GL_WRITE_ONLY, GL_RGBA8);
+    counters.bind_base(GL_SHADER_STORAGE_BUFFER, 2);
+
+    const GLuint paths = (GLuint)width * height;
+    const GLuint tiles_x = (width + 7) / 8, tiles_y = (height + 7) / 8;
+    kernel_barrier();
+    counters.write((GLuint)0, offsetof(Counters, ray_casts));
+    for (int sample = 0; sample < samples; sample++)
+    {
+        kernel_barrier();
+        // Only the dispatch and queue sizes, the ray count runs over the whole frame.
+        const GLuint start[5]{(paths + group_size - 1) / group_size, 1, 1, paths, 0};
+        counters.write(start);
+        size_t current = 0;
+        queues[current].bind_base(GL_SHADER_STORAGE_BUFFER, 0);
+        queues[current ^ 1].bind_base(GL_SHADER_STORAGE_BUFFER, 1);
+        generate.set("sample_index", frame_index * samples + sample);
+        generate.dispatch(tiles_x, tiles_y);
+        for (int bounce = 0; bounce < bounces; bounce++)
+        {
+            kernel_barrier();
+            intersect.dispatch_indirect(counters);
+            kernel_barrier();
+            shade.dispatch_indirect(counters);
+            if (bounce + 1 == bounces)
+            {
+                // Paths still going past the last bounce end dark, as in the fragment shader.
+                break;
+            }
+            kernel_barrier();
+            compact.dispatch_indirect(counters);
+            kernel_barrier();
+            prepare.dispatch(1);
+            current ^= 1;
+            queues[current].bind_base(GL_SHADER_STORAGE_BUFFER, 0);
+            queues[current ^ 1].bind_base(GL_SHADER_STORAGE_BUFFER, 1);
+        }
+    }
+    kernel_barrier();
+    resolve.dispatch(tiles_x, tiles_y);
+    glMemoryBarrier(GL_FRAMEBUFFER_BARRIER_BIT);
+    frame_index++;
+    return output;
+}
+
+GLuint WavefrontTracer::ray_casts() const
+{
+    glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+    Counters values;
+    counters.read(values);
+    return values.ray_casts;
+}
\ No newline at end of file
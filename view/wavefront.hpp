@@ -0,0 +1,47 @@
+#pragma once
+
+#include "camera.hpp"
+#include "raytrace.hpp"
+#include "../opengl/framebuffer.hpp"
+
+#include <optional>
+
+// Compute-shader path tracer (shaders/wavefront): paths wait in storage buffer queues and every bounce runs
+// separate intersect, shade and compact kernels over the paths still alive, so lanes stay coherent and
+// finished paths cost nothing. Samples of a still camera accumulate across frames.
+class WavefrontTracer
+{
+    // std430 layout of the Counters block in shaders/wavefront/path.glsl.
+    struct Counters
+    {
+        GLuint groups[3];
+        GLuint queue_size;
+        GLuint next_queue_size;
+        GLuint ray_casts;
+    };
+    // std430 size of struct Path.
+    inline static constexpr GLsizeiptr path_size = 80;
+    inline static constexpr GLuint group_size = 64;
+    // Same defaults as shaders/raytrace/fragment.glsl.
+    inline static constexpr int default_samples = 10;
+    inline static constexpr int default_bounces = 5;
+    Program generate, intersect, shade, compact, prepare, resolve;
+    const Buffer queues[2];
+    const Buffer counters{};
+    const Texture radiance{};
+    const Framebuffer output;
+    const GLsizei max_width, max_height;
+    const int samples, bounces;
+    std::optional<Camera> accumulated_view;
+    GLsizei accumulated_width = 0, accumulated_height = 0;
+    int frame_index = 0;
+public:
+    // `defines` are those of the fragment-shader variant it stands in for; SAMPLE_COUNT and MAX_BOUNCES become
+    // host loops here.
+    WavefrontTracer(const RayTraceScene&, GLsizei, GLsizei, const ShaderDefines& = {});
+    // Trace one frame into the lower-left `width` x `height` corner of the returned target, with the frame block
+    // already uploaded.
+    const Framebuffer& trace(const Camera&, GLsizei, GLsizei);
+    // Segments intersected during the latest frame; waits for it to finish.
+    GLuint ray_casts() const;
+};
\ No newline at end of file